@@ -0,0 +1,189 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#include "utf8_automaton.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+
+
+namespace
+{
+
+// Edges of a state of the trie (class, state), sorted by class
+using Edges = std::vector<std::pair<std::uint16_t, std::uint32_t>>;
+
+inline bool edge_less( const std::pair<std::uint16_t, std::uint32_t>& e, const std::uint16_t c ) noexcept
+{
+    return e.first < c;
+}
+
+}
+
+
+/*
+    The trie of the patterns is built first, its states are numbered
+    in breadth-first order, so the root and its children come first.
+    Then the failure links are computed in the same order: the root
+    and its children get a full row, the missing transitions are taken
+    from the failure state, so the scan never goes back beyond them.
+    The deeper states only keep the band of their edges in the trie.
+*/
+UTF8automaton::UTF8automaton( const std::vector<UTF8string>& patterns )
+{
+    // Byte classes, class 0 is every byte that is in no pattern
+    for ( const UTF8string& p : patterns )
+    {
+        for ( size_t i = 0; i < p.utf8_size(); ++i )
+        {
+            _utf8class[static_cast<unsigned char>( p.utf8_str()[i] )] = 1U;
+        }
+    }
+
+    for ( size_t b = 0; b < 256; ++b )
+    {
+        if ( _utf8class[b] != 0 )
+            _utf8class[b] = static_cast<std::uint16_t>( _utf8nclasses++ );
+    }
+
+    const size_t NC = _utf8nclasses;
+    std::vector<Edges> trie( 1 );
+    std::vector<std::vector<size_t>> own( 1 );
+
+    for ( size_t id = 0; id < patterns.size(); ++id )
+    {
+        const UTF8string& p = patterns[id];
+        _utf8plength.push_back( p.utf8_length() );
+
+        if ( p.utf8_empty() )
+            continue;
+
+        size_t state = 0;
+
+        for ( size_t i = 0; i < p.utf8_size(); ++i )
+        {
+            const std::uint16_t C = _utf8class[static_cast<unsigned char>( p.utf8_str()[i] )];
+            Edges& edges = trie[state];
+            const Edges::iterator IT = std::lower_bound( edges.begin(), edges.end(), C, edge_less );
+
+            if ( IT != edges.end() && IT->first == C )
+            {
+                state = IT->second;
+                continue;
+            }
+
+            if ( trie.size() > std::numeric_limits<std::uint32_t>::max() - 1U )
+                throw std::length_error( "UTF8automaton - too many states" );
+
+            const std::uint32_t T = static_cast<std::uint32_t>( trie.size() );
+            edges.insert( IT, std::make_pair( C, T ) );
+            trie.emplace_back();
+            own.emplace_back();
+            state = T;
+        }
+
+        own[state].push_back( id );
+    }
+
+    // Breadth-first numbering: order[new state] = trie state, rank[trie state] = new state
+    const size_t NSTATES = trie.size();
+    std::vector<std::uint32_t> order( 1, 0U );
+    std::vector<std::uint32_t> rank( NSTATES, 0U );
+    order.reserve( NSTATES );
+
+    for ( size_t k = 0; k < order.size(); ++k )
+    {
+        for ( const std::pair<std::uint16_t, std::uint32_t>& e : trie[order[k]] )
+        {
+            rank[e.second] = static_cast<std::uint32_t>( order.size() );
+            order.push_back( e.second );
+        }
+    }
+
+    // Transitions and failure links, a state is built after its failure state
+    std::vector<std::uint32_t> fail( NSTATES, 0U );
+    _utf8ndense = 1U + trie[0].size();
+    _utf8delta.assign( _utf8ndense * NC, 0U );
+    _utf8rows.reserve( NSTATES - _utf8ndense );
+
+    for ( size_t S = 0; S < NSTATES; ++S )
+    {
+        const Edges& edges = trie[order[S]];
+
+        if ( S < _utf8ndense )
+        {
+            const size_t ROW = S * NC;
+
+            // The row of the root is the only one without a failure state
+            if ( S != 0 )
+                std::copy( _utf8delta.begin() + static_cast<std::ptrdiff_t>( fail[S] * NC ),
+                           _utf8delta.begin() + static_cast<std::ptrdiff_t>( fail[S] * NC + NC ),
+                           _utf8delta.begin() + static_cast<std::ptrdiff_t>( ROW ) );
+
+            for ( const std::pair<std::uint16_t, std::uint32_t>& e : edges )
+                _utf8delta[ROW + e.first] = rank[e.second];
+        }
+        else
+        {
+            if ( _utf8band.size() > std::numeric_limits<std::uint32_t>::max() - NC )
+                throw std::length_error( "UTF8automaton - too many transitions" );
+
+            const std::uint16_t LOW = edges.empty() ? 0U : edges.front().first;
+            const std::uint16_t WIDTH = edges.empty() ? 0U : static_cast<std::uint16_t>( edges.back().first - LOW + 1 );
+            const std::uint32_t POS = static_cast<std::uint32_t>( _utf8band.size() );
+            _utf8band.resize( _utf8band.size() + WIDTH, 0U );
+
+            for ( const std::pair<std::uint16_t, std::uint32_t>& e : edges )
+                _utf8band[POS + e.first - LOW] = rank[e.second];
+
+            _utf8rows.push_back( Row{ POS, fail[S], LOW, WIDTH } );
+        }
+
+        for ( const std::pair<std::uint16_t, std::uint32_t>& e : edges )
+            fail[rank[e.second]] = S == 0 ? 0U : utf8_next_( fail[S], e.first );
+    }
+
+    // Outputs, the ones of a state include the ones of its failure state,
+    // which is closer to the root
+    std::vector<std::vector<size_t>> out( NSTATES );
+    _utf8outpos.reserve( NSTATES + 1 );
+    _utf8outpos.push_back( 0U );
+
+    for ( size_t S = 0; S < NSTATES; ++S )
+    {
+        out[S] = std::move( own[order[S]] );
+
+        if ( S != 0 )
+            out[S].insert( out[S].end(), out[fail[S]].begin(), out[fail[S]].end() );
+
+        _utf8outid.insert( _utf8outid.end(), out[S].begin(), out[S].end() );
+        _utf8outpos.push_back( _utf8outid.size() );
+    }
+}
+
+
+std::vector<UTF8automaton::match> UTF8automaton::utf8_find_all( const UTF8string_view& str ) const
+{
+    std::vector<match> matches;
+    utf8_scan( str, [&matches]( size_t id, size_t pos )
+    {
+        matches.emplace_back( id, pos );
+    } );
+    return matches;
+}
+
+
+size_t UTF8automaton::utf8_states() const noexcept
+{
+    return _utf8outpos.empty() ? 0U : _utf8outpos.size() - 1;
+}
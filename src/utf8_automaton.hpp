@@ -0,0 +1,172 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#ifndef UTF8_AUTOMATON_HPP_INCLUDED
+#define UTF8_AUTOMATON_HPP_INCLUDED
+
+/**
+*   @file utf8_automaton.hpp
+*   @brief This is a UTF-8 string library header
+*/
+
+#include "utf8_string.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+*   @class UTF8automaton final
+*   @brief Search for several patterns at once
+*
+*   This class defines an Aho-Corasick automaton built from a set of
+*   utf-8 strings. A string is scanned once to find every occurrence
+*   of every pattern, whatever the number of patterns.
+*
+*   The automaton works on the bytes. The bytes that appear in the patterns
+*   are mapped to a small number of classes. The root and the states
+*   at depth 1 have a full row of transitions, one entry per class.
+*   A deeper state only keeps the band of classes that covers its edges
+*   in the trie and a failure link, so the table grows with the number
+*   of edges, not with states × classes.
+*
+*   @note The memory used by the transitions is at most
+*         (1 + C) × C × 4 bytes for the full rows, plus 12 bytes
+*         per deeper state and 4 bytes per entry of its band,
+*         C being the number of classes (256 at most).
+*/
+class UTF8automaton final
+{
+    // Band of a deep state: _utf8band[pos .. pos + width] for the classes low .. low + width
+    struct Row
+    {
+        std::uint32_t pos;
+        std::uint32_t fail;
+        std::uint16_t low;
+        std::uint16_t width;
+    };
+
+    std::uint16_t _utf8class[256] = {};
+    size_t _utf8nclasses = 1U;
+    // States below _utf8ndense (the root and depth 1): _utf8delta[state * _utf8nclasses + class]
+    size_t _utf8ndense = 1U;
+    std::vector<std::uint32_t> _utf8delta = {};
+    // Other states: _utf8rows[state - _utf8ndense], 0 in a band is a missing edge
+    std::vector<Row> _utf8rows = {};
+    std::vector<std::uint32_t> _utf8band = {};
+    // Patterns found in a state: _utf8outid[_utf8outpos[state] .. _utf8outpos[state + 1]]
+    std::vector<size_t> _utf8outpos = {};
+    std::vector<size_t> _utf8outid = {};
+    // Length of the patterns (in number of codepoints)
+    std::vector<size_t> _utf8plength = {};
+
+    std::uint32_t utf8_next_( std::uint32_t state, const std::uint16_t c ) const noexcept;
+
+public:
+
+    /**
+    *   @typedef match
+    *   @brief A match: the identifier of the pattern (*first*)
+    *          and its position in the string (*second*, in number of codepoints)
+    */
+    using match = std::pair<size_t, size_t>;
+
+    /**
+    *   @fn explicit UTF8automaton(const std::vector<UTF8string>& patterns)
+    *
+    *   Build the automaton. The identifier of a pattern is its index
+    *   in the vector. Empty patterns are never found.
+    *
+    *   @param patterns The utf-8 strings to look for
+    *   @exception std::length_error If the patterns are too large
+    */
+    explicit UTF8automaton( const std::vector<UTF8string>& patterns );
+
+    /**
+    *   @fn std::vector<UTF8automaton::match> utf8_find_all(const UTF8string_view& str) const
+    *
+    *   Find every occurrence of every pattern in a string,
+    *   overlapping occurrences included.
+    *
+    *   @param str The string to search in
+    *   @return The matches, sorted by end position. Matches that end at
+    *           the same position are sorted from the longest pattern
+    *           to the shortest one.
+    */
+    std::vector<match> utf8_find_all( const UTF8string_view& str ) const;
+    /**
+    *   @fn template <typename Function> void utf8_scan(const UTF8string_view& str, Function f) const
+    *
+    *   Same as utf8_find_all(), but every match is given to *f*
+    *   as soon as it is found, nothing is allocated.
+    *
+    *   @param str The string to search in
+    *   @param f The function called as ```f(id, pos)``` for every match
+    */
+    template <typename Function>
+    void utf8_scan( const UTF8string_view& str, Function f ) const;
+
+    /**
+    *   @fn size_t utf8_states() const noexcept
+    *   @return The number of states of the automaton
+    */
+    size_t utf8_states() const noexcept;
+
+    ~UTF8automaton() = default;
+};
+
+
+// A deep state follows its failure links until the edge is found,
+// or until a state with a full row is reached
+inline std::uint32_t UTF8automaton::utf8_next_( std::uint32_t state, const std::uint16_t c ) const noexcept
+{
+    while ( state >= _utf8ndense )
+    {
+        const Row& R = _utf8rows[state - _utf8ndense];
+
+        if ( c >= R.low && c - R.low < R.width )
+        {
+            const std::uint32_t T = _utf8band[R.pos + c - R.low];
+
+            if ( T != 0 )
+                return T;
+        }
+
+        state = R.fail;
+    }
+
+    return _utf8delta[state * _utf8nclasses + c];
+}
+
+
+template <typename Function>
+void UTF8automaton::utf8_scan( const UTF8string_view& str, Function f ) const
+{
+    const unsigned char * const DATA = reinterpret_cast<const unsigned char *>( str.utf8_data() );
+    const size_t SIZE = str.utf8_size();
+    std::uint32_t state = 0U;
+    size_t cpos = 0U;   // Number of codepoints that start before or at i
+
+    for ( size_t i = 0; i < SIZE; ++i )
+    {
+        cpos += ( DATA[i] & 0xC0 ) != 0x80;
+        state = utf8_next_( state, _utf8class[DATA[i]] );
+
+        for ( size_t k = _utf8outpos[state]; k < _utf8outpos[state + 1]; ++k )
+        {
+            const size_t ID = _utf8outid[k];
+            f( ID, cpos - _utf8plength[ID] );
+        }
+    }
+}
+
+#endif // UTF8_AUTOMATON_HPP_INCLUDED
@@ -0,0 +1,119 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#include "utf8_builder.hpp"
+#include "utf8_kernel.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <utility>
+
+
+void UTF8builder::utf8_reserve( const size_t size )
+{
+    _utf8buffer.reserve( size );
+}
+
+
+UTF8builder& UTF8builder::utf8_append( const char32_t codepoint )
+{
+    char bytes[4];
+    const size_t N = utf8_kernel::encode( codepoint, bytes );
+
+    if ( N == 0 )
+        throw std::invalid_argument( "Invalid codepoint\n" );
+
+    _utf8buffer.append( bytes, N );
+    _utf8length += 1;
+    return *this;
+}
+
+// An empty UTF8char has no codepoint, nothing is appended
+UTF8builder& UTF8builder::utf8_append( const UTF8char& c )
+{
+    if ( c.utf8_size() == 0 )
+        return *this;
+
+    _utf8buffer.append( c.utf8_str(), c.utf8_size() );
+    _utf8length += 1;
+    return *this;
+}
+
+UTF8builder& UTF8builder::utf8_append( const UTF8string_view& u8str )
+{
+    _utf8buffer.append( u8str.utf8_data(), u8str.utf8_size() );
+    _utf8length += u8str.utf8_length();
+    return *this;
+}
+
+UTF8builder& UTF8builder::utf8_append( const UTF8string& u8str )
+{
+    _utf8buffer.append( u8str.utf8_str(), u8str.utf8_size() );
+    _utf8length += u8str.utf8_length();
+    return *this;
+}
+
+UTF8builder& UTF8builder::utf8_append( const std::string& str )
+{
+    const size_t LEN = UTF8string::utf8_validate_( str.data(), str.size() );
+    _utf8buffer += str;
+    _utf8length += LEN;
+    return *this;
+}
+
+UTF8builder& UTF8builder::utf8_append( const char * str )
+{
+    const size_t SZ = std::strlen( str );
+    const size_t LEN = UTF8string::utf8_validate_( str, SZ );
+    _utf8buffer.append( str, SZ );
+    _utf8length += LEN;
+    return *this;
+}
+
+UTF8builder& UTF8builder::utf8_append_unchecked( const char * data, const size_t size )
+{
+    _utf8buffer.append( data, size );
+    _utf8length += utf8_kernel::count( data, size );
+    return *this;
+}
+
+
+void UTF8builder::utf8_clear() noexcept
+{
+    _utf8buffer.clear();
+    _utf8length = 0;
+}
+
+size_t UTF8builder::utf8_size() const noexcept
+{
+    return _utf8buffer.size();
+}
+
+size_t UTF8builder::utf8_length() const noexcept
+{
+    return _utf8length;
+}
+
+
+UTF8string UTF8builder::utf8_build() const &
+{
+    return UTF8string( _utf8buffer.data(), _utf8buffer.size(), _utf8length );
+}
+
+UTF8string UTF8builder::utf8_build() && noexcept
+{
+    UTF8string u8str;
+    u8str._utf8string = std::move( _utf8buffer );
+    u8str._utf8length = _utf8length;
+    utf8_clear();
+    return u8str;
+}
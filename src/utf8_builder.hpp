@@ -0,0 +1,146 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#ifndef UTF8_BUILDER_HPP_INCLUDED
+#define UTF8_BUILDER_HPP_INCLUDED
+
+/**
+*   @file utf8_builder.hpp
+*   @brief This is a UTF-8 string library header
+*/
+
+#include "utf8_string.hpp"
+
+#include <string>
+
+/**
+*   @class UTF8builder final
+*   @brief Builder of UTF-8 strings
+*
+*   This class assembles a utf-8 string from many fragments.
+*   Only the fragments that are not known to be valid are checked,
+*   and the number of codepoints is updated at each append,
+*   so the final string is neither checked nor counted again.
+*/
+class UTF8builder final
+{
+    std::string _utf8buffer = {};
+    size_t _utf8length = 0U;
+
+public:
+
+    /**
+    *   @fn UTF8builder() = default
+    */
+    UTF8builder() = default;
+
+    /**
+    *   @fn void utf8_reserve(const size_t size)
+    *   Reserve memory for the content
+    *   @param size The expected size of the string (in bytes)
+    */
+    void utf8_reserve( const size_t size );
+
+    /**
+    *   @fn UTF8builder& utf8_append(const char32_t codepoint)
+    *
+    *   Encode a codepoint at the end of the string
+    *
+    *   @param codepoint The Unicode codepoint
+    *   @return A reference to the builder
+    *   @exception std::invalid_argument If the value is not a valid codepoint
+    *              (surrogate or greater than U+10FFFF)
+    */
+    UTF8builder& utf8_append( const char32_t codepoint );
+    /**
+    *   @fn UTF8builder& utf8_append(const UTF8char& c)
+    *   @param c The codepoint to append, nothing is appended if it is empty
+    *   @return A reference to the builder
+    */
+    UTF8builder& utf8_append( const UTF8char& c );
+    /**
+    *   @fn UTF8builder& utf8_append(const UTF8string_view& u8str)
+    *   @param u8str The utf-8 string to append, it is not checked
+    *   @return A reference to the builder
+    */
+    UTF8builder& utf8_append( const UTF8string_view& u8str );
+    /**
+    *   @fn UTF8builder& utf8_append(const UTF8string& u8str)
+    *   @param u8str The utf-8 string to append, it is not checked
+    *   @return A reference to the builder
+    */
+    UTF8builder& utf8_append( const UTF8string& u8str );
+    /**
+    *   @fn UTF8builder& utf8_append(const std::string& str)
+    *   @param str The string to append
+    *   @return A reference to the builder
+    *   @exception std::invalid_argument If the string is not valid
+    *   @note If an exception is thrown, the builder is not modified
+    */
+    UTF8builder& utf8_append( const std::string& str );
+    /**
+    *   @fn UTF8builder& utf8_append(const char * str)
+    *   @param str The C-string to append
+    *   @return A reference to the builder
+    *   @exception std::invalid_argument If the string is not valid
+    *   @note If an exception is thrown, the builder is not modified
+    */
+    UTF8builder& utf8_append( const char * str );
+    /**
+    *   @fn UTF8builder& utf8_append_unchecked(const char * data, const size_t size)
+    *
+    *   Append bytes that are already known to be a valid utf-8 sequence.
+    *   They are counted, but not checked.
+    *
+    *   @param data The bytes to append
+    *   @param size The number of bytes
+    *   @return A reference to the builder
+    *   @pre data is a valid utf-8 sequence, otherwise the string built
+    *        by utf8_build() is not valid and the behaviour is undefined
+    */
+    UTF8builder& utf8_append_unchecked( const char * data, const size_t size );
+
+    /**
+    *   @fn void utf8_clear() noexcept
+    *   Clear the content of the builder
+    */
+    void utf8_clear() noexcept;
+    /**
+    *   @fn size_t utf8_size() const noexcept
+    *   @return The memory size (in bytes) of the content
+    */
+    size_t utf8_size() const noexcept;
+    /**
+    *   @fn size_t utf8_length() const noexcept
+    *   @return The length of the content (in number of codepoints)
+    */
+    size_t utf8_length() const noexcept;
+
+    /**
+    *   @fn UTF8string utf8_build() const &
+    *   @return A copy of the content, it is not checked again
+    */
+    UTF8string utf8_build() const &;
+    /**
+    *   @fn UTF8string utf8_build() && noexcept
+    *
+    *   Move the buffer of the builder into a utf-8 string,
+    *   nothing is copied or checked. The builder is empty after the call.
+    *
+    *   @return The utf-8 string
+    */
+    UTF8string utf8_build() && noexcept;
+
+    ~UTF8builder() = default;
+};
+
+#endif // UTF8_BUILDER_HPP_INCLUDED
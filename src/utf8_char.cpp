@@ -0,0 +1,157 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#include "utf8_char.hpp"
+#include "utf8_kernel.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+
+UTF8char::UTF8char( const char * data, const size_t size ) noexcept
+    : _size( static_cast<unsigned char>( size ) )
+{
+    std::memcpy( _data, data, size );
+}
+
+UTF8char::UTF8char( const char32_t codepoint )
+    : _size( static_cast<unsigned char>( utf8_kernel::encode( codepoint, _data ) ) )
+{
+    if ( _size == 0 )
+        throw std::invalid_argument( "Invalid codepoint\n" );
+}
+
+UTF8char::UTF8char( const std::string& str )
+    : UTF8char( str.data(), str.size() < 4 ? str.size() : 4 )
+{
+    if ( str.size() > 4 || utf8_kernel::length( str.data(), str.size() ) != 1 )
+        throw std::invalid_argument( "The string is not a single UTF-8 codepoint\n" );
+}
+
+
+size_t UTF8char::utf8_size() const noexcept
+{
+    return _size;
+}
+
+char32_t UTF8char::utf8_codepoint() const noexcept
+{
+    const unsigned char * b = reinterpret_cast<const unsigned char *>( _data );
+
+    switch ( _size )
+    {
+    case 1:
+        return b[0];
+
+    case 2:
+        return ( char32_t( b[0] & 0x1F ) << 6 ) | char32_t( b[1] & 0x3F );
+
+    case 3:
+        return ( char32_t( b[0] & 0x0F ) << 12 ) | ( char32_t( b[1] & 0x3F ) << 6 )
+               | char32_t( b[2] & 0x3F );
+
+    case 4:
+        return ( char32_t( b[0] & 0x07 ) << 18 ) | ( char32_t( b[1] & 0x3F ) << 12 )
+               | ( char32_t( b[2] & 0x3F ) << 6 ) | char32_t( b[3] & 0x3F );
+
+    default:
+        return 0;
+    }
+}
+
+const char * UTF8char::utf8_str() const noexcept
+{
+    return _data;
+}
+
+std::string UTF8char::utf8_sstring() const
+{
+    // At most 4 bytes: short string optimization, no allocation
+    return std::string( _data, _size );
+}
+
+size_t UTF8char::hash() const noexcept
+{
+    // The bytes are packed into an integer. The first byte gives
+    // the length of the sequence, so two codepoints never collide.
+    const unsigned char * b = reinterpret_cast<const unsigned char *>( _data );
+    return ( size_t( b[0] ) << 24 ) | ( size_t( b[1] ) << 16 )
+           | ( size_t( b[2] ) << 8 ) | size_t( b[3] );
+}
+
+UTF8char::operator std::string() const
+{
+    return utf8_sstring();
+}
+
+
+bool operator ==( const UTF8char& c1, const UTF8char& c2 ) noexcept
+{
+    return c1.utf8_size() == c2.utf8_size()
+           && std::memcmp( c1.utf8_str(), c2.utf8_str(), c1.utf8_size() ) == 0;
+}
+
+bool operator !=( const UTF8char& c1, const UTF8char& c2 ) noexcept
+{
+    return !( c1 == c2 );
+}
+
+bool operator <( const UTF8char& c1, const UTF8char& c2 ) noexcept
+{
+    // The byte order of UTF-8 sequences is the order of the codepoints.
+    // Compare the bytes, not a C string: U+0000 is a one-byte '\0'
+    const size_t LEN = std::min( c1.utf8_size(), c2.utf8_size() );
+    const int CMP = std::memcmp( c1.utf8_str(), c2.utf8_str(), LEN );
+    return CMP < 0 || ( CMP == 0 && c1.utf8_size() < c2.utf8_size() );
+}
+
+
+bool operator ==( const UTF8char& c, const std::string& str ) noexcept
+{
+    return c.utf8_size() == str.size()
+           && std::memcmp( c.utf8_str(), str.data(), str.size() ) == 0;
+}
+
+bool operator ==( const std::string& str, const UTF8char& c ) noexcept
+{
+    return c == str;
+}
+
+bool operator !=( const UTF8char& c, const std::string& str ) noexcept
+{
+    return !( c == str );
+}
+
+bool operator !=( const std::string& str, const UTF8char& c ) noexcept
+{
+    return !( c == str );
+}
+
+
+bool operator ==( const UTF8char& c, const char * str ) noexcept
+{
+    const size_t LEN = std::strlen( str );
+    return c.utf8_size() == LEN && std::memcmp( c.utf8_str(), str, LEN ) == 0;
+}
+
+bool operator !=( const UTF8char& c, const char * str ) noexcept
+{
+    return !( c == str );
+}
+
+
+std::ostream& operator <<( std::ostream& os, const UTF8char& c )
+{
+    os.write( c.utf8_str(), static_cast<std::streamsize>( c.utf8_size() ) );
+    return os;
+}
@@ -0,0 +1,189 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#ifndef UTF8_CHAR_HPP_INCLUDED
+#define UTF8_CHAR_HPP_INCLUDED
+
+/**
+*   @file utf8_char.hpp
+*   @brief This is a UTF-8 string library header
+*/
+
+#include <string>
+#include <iostream>
+
+/**
+*   @class UTF8char final
+*   @brief UTF-8 character
+*
+*   This class defines a codepoint of a UTF-8 string.
+*
+*   The bytes of the codepoint are stored inline, so the object is
+*   trivially copyable and never allocates memory.
+*/
+class UTF8char final
+{
+    char _data[5] = {0, 0, 0, 0, 0};
+    unsigned char _size = 0U;
+
+    UTF8char( const char * data, const size_t size ) noexcept;
+
+    template <typename> friend class UTF8basic_string;
+    friend class UTF8iterator;
+    friend class UTF8string_view;
+
+public:
+
+    /**
+    *   @fn UTF8char() noexcept
+    *   Build an empty character (no codepoint)
+    */
+    UTF8char() noexcept = default;
+    /**
+    *   @fn explicit UTF8char(const char32_t codepoint)
+    *   @param codepoint The Unicode codepoint
+    *   @exception std::invalid_argument If the value is not a valid codepoint
+    *              (surrogate or greater than U+10FFFF)
+    */
+    explicit UTF8char( const char32_t codepoint );
+    /**
+    *   @fn explicit UTF8char(const std::string& str)
+    *   @param str A string that contains exactly one codepoint
+    *   @exception std::invalid_argument If the string is not valid or does
+    *              not contain exactly one codepoint
+    */
+    explicit UTF8char( const std::string& str );
+
+    /**
+    *   @fn size_t utf8_size() const noexcept
+    *   Get the memory size (in bytes) of the codepoint
+    *   @return The memory size of the codepoint (between 1 and 4)
+    */
+    size_t utf8_size() const noexcept;
+    /**
+    *   @fn char32_t utf8_codepoint() const noexcept
+    *   Get the value of the codepoint
+    *   @return The Unicode codepoint
+    */
+    char32_t utf8_codepoint() const noexcept;
+    /**
+    *   @fn const char * utf8_str() const noexcept
+    *   Returns a pointer to the bytes of the codepoint (null-terminated)
+    *   @return A pointer to a C-string
+    */
+    const char * utf8_str() const noexcept;
+    /**
+    *   @fn std::string utf8_sstring() const
+    *   Returns the string related to the codepoint
+    *   @return The string
+    */
+    std::string utf8_sstring() const;
+    /**
+    *   @fn size_t hash() const noexcept
+    *   Generate a hash value of the codepoint
+    *   @return The hash value
+    */
+    size_t hash() const noexcept;
+
+    /**
+    *   @fn operator std::string() const
+    *   Convert the codepoint into a string
+    *   @note Same as utf8_sstring()
+    */
+    operator std::string() const;
+
+    ~UTF8char() = default;
+};
+
+
+namespace std
+{
+
+template<>
+class hash<UTF8char>
+{
+public:
+    size_t operator()( const UTF8char& u8c ) const noexcept
+    {
+        return u8c.hash();
+    }
+};
+
+}
+
+
+/**
+*   @fn bool operator ==(const UTF8char& c1, const UTF8char& c2) noexcept
+*   @param c1 utf-8 character
+*   @param c2 utf-8 character
+*   @return TRUE if they are the same codepoint, FALSE otherwise
+*/
+bool operator ==( const UTF8char& c1, const UTF8char& c2 ) noexcept;
+/**
+*   @fn bool operator !=(const UTF8char& c1, const UTF8char& c2) noexcept
+*   @param c1 utf-8 character
+*   @param c2 utf-8 character
+*   @return TRUE if they are different codepoints, FALSE otherwise
+*/
+bool operator !=( const UTF8char& c1, const UTF8char& c2 ) noexcept;
+/**
+*   @fn bool operator <(const UTF8char& c1, const UTF8char& c2) noexcept
+*   @param c1 utf-8 character
+*   @param c2 utf-8 character
+*   @return TRUE if the codepoint c1 is less than c2, FALSE otherwise
+*/
+bool operator <( const UTF8char& c1, const UTF8char& c2 ) noexcept;
+
+/**
+*   @fn bool operator ==(const UTF8char& c, const std::string& str) noexcept
+*   @param c utf-8 character
+*   @param str string
+*   @return TRUE if the string contains exactly the bytes of the codepoint,
+*           FALSE otherwise
+*/
+bool operator ==( const UTF8char& c, const std::string& str ) noexcept;
+/**
+*   @fn bool operator ==(const std::string& str, const UTF8char& c) noexcept
+*/
+bool operator ==( const std::string& str, const UTF8char& c ) noexcept;
+/**
+*   @fn bool operator !=(const UTF8char& c, const std::string& str) noexcept
+*/
+bool operator !=( const UTF8char& c, const std::string& str ) noexcept;
+/**
+*   @fn bool operator !=(const std::string& str, const UTF8char& c) noexcept
+*/
+bool operator !=( const std::string& str, const UTF8char& c ) noexcept;
+
+/**
+*   @fn bool operator ==(const UTF8char& c, const char * str) noexcept
+*   @param c utf-8 character
+*   @param str C-string
+*   @return TRUE if the string contains exactly the bytes of the codepoint,
+*           FALSE otherwise
+*/
+bool operator ==( const UTF8char& c, const char * str ) noexcept;
+/**
+*   @fn bool operator !=(const UTF8char& c, const char * str) noexcept
+*/
+bool operator !=( const UTF8char& c, const char * str ) noexcept;
+
+/**
+*   @fn std::ostream& operator <<(std::ostream& os, const UTF8char& c)
+*   Insert a codepoint into a stream.
+*   @param os The output stream
+*   @param c The codepoint
+*   @return The same as parameter *os*
+*/
+std::ostream& operator <<( std::ostream& os, const UTF8char& c );
+
+#endif // UTF8_CHAR_HPP_INCLUDED
@@ -0,0 +1,45 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#ifndef UTF8_ERROR_HPP_INCLUDED
+#define UTF8_ERROR_HPP_INCLUDED
+
+/**
+*   @file utf8_error.hpp
+*   @brief This is a UTF-8 string library header
+*/
+
+/**
+*   @enum UTF8error
+*   @brief Kind of the first invalid sequence found in a buffer
+*/
+enum class UTF8error : unsigned char
+{
+    /// The buffer is valid
+    NONE,
+    /// A continuation byte (0x80 to 0xBF) that does not follow a leading byte
+    UNEXPECTED_CONTINUATION,
+    /// A leading byte that is not followed by enough continuation bytes
+    MISSING_CONTINUATION,
+    /// The buffer ends in the middle of a sequence
+    TRUNCATED,
+    /// A codepoint encoded with more bytes than needed (0xC0, 0xC1, 0xE0 0x80..0x9F, 0xF0 0x80..0x8F)
+    OVERLONG,
+    /// A UTF-16 surrogate (U+D800 to U+DFFF)
+    SURROGATE,
+    /// A codepoint greater than U+10FFFF
+    TOO_LARGE,
+    /// A byte never used in UTF-8 (0xF5 to 0xFF)
+    INVALID_BYTE
+};
+
+#endif // UTF8_ERROR_HPP_INCLUDED
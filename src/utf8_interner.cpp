@@ -0,0 +1,275 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#include "utf8_interner.hpp"
+#include "utf8_records.hpp"
+#include "utf8_kernel.hpp"
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+
+namespace
+{
+
+// The strings are stored into blocks of this size (in bytes)
+constexpr size_t UTF8_BLOCK_SIZE = 65536U;
+// The size of the table is at least twice the number of strings
+constexpr size_t UTF8_TABLE_MIN_SIZE = 16U;
+// Fibonacci hashing: the slot is taken from the high bits of the product
+constexpr size_t UTF8_TABLE_MULTIPLIER = static_cast<size_t>( 0x9E3779B97F4A7C15ULL );
+constexpr unsigned UTF8_SIZE_BITS = sizeof( size_t ) * 8U;
+
+}
+
+
+UTF8interner::UTF8interner( UTF8interner&& interner ) noexcept
+    : UTF8interner()
+{
+    *this = std::move( interner );
+}
+
+UTF8interner& UTF8interner::operator =( UTF8interner&& interner ) noexcept
+{
+    if ( this != &interner )
+    {
+        _utf8blocks    = std::move( interner._utf8blocks );
+        _utf8cursor    = interner._utf8cursor;
+        _utf8available = interner._utf8available;
+        _utf8allocated = interner._utf8allocated;
+        _utf8bytes     = interner._utf8bytes;
+        _utf8count     = interner._utf8count;
+        _utf8table     = std::move( interner._utf8table );
+        _utf8shift     = interner._utf8shift;
+
+        // The blocks belong to the current table now
+        interner._utf8blocks.clear();
+        interner._utf8table.clear();
+        interner._utf8cursor    = nullptr;
+        interner._utf8available = 0U;
+        interner._utf8allocated = 0U;
+        interner._utf8bytes     = 0U;
+        interner._utf8count     = 0U;
+        interner._utf8shift     = 0U;
+    }
+
+    return *this;
+}
+
+
+// The bytes of a string are stored right after its entry
+UTF8string_view UTF8interner::utf8_view_( const Entry * entry ) noexcept
+{
+    return UTF8string_view( reinterpret_cast<const char *>( entry + 1 ), entry->size, entry->length );
+}
+
+size_t UTF8interner::utf8_slot_( const size_t hash ) const noexcept
+{
+    return ( hash * UTF8_TABLE_MULTIPLIER ) >> _utf8shift;
+}
+
+const UTF8interner::Entry * UTF8interner::utf8_find_( const char * data, const size_t size,
+                                                      const size_t hash ) const noexcept
+{
+    if ( _utf8table.empty() )
+        return nullptr;
+
+    const size_t MASK = _utf8table.size() - 1;
+
+    for ( size_t i = utf8_slot_( hash ); _utf8table[i] != nullptr; i = ( i + 1 ) & MASK )
+    {
+        const Entry * const E = _utf8table[i];
+
+        // The hash values are compared first, the bytes are rarely compared
+        if ( E->hash == hash && E->size == size
+                && ( size == 0 || std::memcmp( E + 1, data, size ) == 0 ) )
+            return E;
+    }
+
+    return nullptr;
+}
+
+const UTF8interner::Entry * UTF8interner::utf8_store_( const UTF8string_view& str, const size_t hash )
+{
+    // Every entry is aligned, the bytes of the previous string are padded
+    const size_t ALIGN = alignof( Entry );
+    const size_t NEEDED = ( sizeof( Entry ) + str.utf8_size() + ALIGN - 1 ) & ~( ALIGN - 1 );
+
+    char * place = _utf8cursor;
+
+    if ( NEEDED > UTF8_BLOCK_SIZE / 4 )
+    {
+        // A long string gets its own block, the current block is kept.
+        // The block is owned before the vector grows, so it cannot leak
+        std::unique_ptr<char[]> block( new char[NEEDED] );
+        _utf8blocks.push_back( std::move( block ) );
+        _utf8allocated += NEEDED;
+        place = _utf8blocks.back().get();
+    }
+    else
+    {
+        if ( NEEDED > _utf8available )
+        {
+            std::unique_ptr<char[]> block( new char[UTF8_BLOCK_SIZE] );
+            _utf8blocks.push_back( std::move( block ) );
+            _utf8allocated += UTF8_BLOCK_SIZE;
+            _utf8cursor    = _utf8blocks.back().get();
+            _utf8available = UTF8_BLOCK_SIZE;
+        }
+
+        place = _utf8cursor;
+        _utf8cursor    += NEEDED;
+        _utf8available -= NEEDED;
+    }
+
+    Entry * const E = new ( place ) Entry{ hash, str.utf8_size(), str.utf8_length() };
+
+    // The data of an empty view can be null
+    if ( !str.utf8_empty() )
+        std::memcpy( E + 1, str.utf8_data(), str.utf8_size() );
+
+    _utf8bytes += str.utf8_size();
+    return E;
+}
+
+// Build a table for count strings, the entries are not moved
+void UTF8interner::utf8_rehash_( const size_t count )
+{
+    size_t tsize = UTF8_TABLE_MIN_SIZE;
+    unsigned bits = 4U;
+
+    while ( tsize < count * 2 )
+    {
+        tsize *= 2;
+        bits  += 1;
+    }
+
+    if ( tsize <= _utf8table.size() )
+        return;
+
+    std::vector<const Entry *> table( tsize, nullptr );
+    const size_t MASK = tsize - 1;
+    _utf8shift = UTF8_SIZE_BITS - bits;
+
+    for ( const Entry * E : _utf8table )
+    {
+        if ( E == nullptr )
+            continue;
+
+        size_t i = utf8_slot_( E->hash );
+
+        while ( table[i] != nullptr )
+            i = ( i + 1 ) & MASK;
+
+        table[i] = E;
+    }
+
+    _utf8table.swap( table );
+}
+
+
+void UTF8interner::utf8_reserve( const size_t count )
+{
+    utf8_rehash_( count );
+}
+
+
+UTF8interner::handle UTF8interner::utf8_intern_( const UTF8string_view& str, const size_t hash )
+{
+    const Entry * E = utf8_find_( str.utf8_data(), str.utf8_size(), hash );
+
+    if ( E != nullptr )
+        return handle( E );
+
+    utf8_rehash_( _utf8count + 1 );
+    E = utf8_store_( str, hash );
+
+    const size_t MASK = _utf8table.size() - 1;
+    size_t i = utf8_slot_( hash );
+
+    while ( _utf8table[i] != nullptr )
+        i = ( i + 1 ) & MASK;
+
+    _utf8table[i] = E;
+    _utf8count += 1;
+    return handle( E );
+}
+
+
+UTF8interner::handle UTF8interner::utf8_intern( const UTF8string_view& str )
+{
+    return utf8_intern_( str, str.hash() );
+}
+
+// The hash value of a utf-8 string is kept by the string
+UTF8interner::handle UTF8interner::utf8_intern( const UTF8string& str )
+{
+    return utf8_intern_( str, str.hash() );
+}
+
+std::vector<UTF8interner::handle> UTF8interner::utf8_intern( const std::vector<UTF8string>& strings )
+{
+    std::vector<handle> handles;
+    handles.reserve( strings.size() );
+
+    for ( const UTF8string& s : strings )
+    {
+        handles.push_back( utf8_intern( s ) );
+    }
+
+    return handles;
+}
+
+std::vector<UTF8interner::handle> UTF8interner::utf8_intern( const std::vector<UTF8string_view>& strings )
+{
+    std::vector<handle> handles;
+    handles.reserve( strings.size() );
+
+    for ( const UTF8string_view& s : strings )
+    {
+        handles.push_back( utf8_intern( s ) );
+    }
+
+    return handles;
+}
+
+std::vector<UTF8interner::handle> UTF8interner::utf8_intern( const UTF8records& records )
+{
+    std::vector<handle> handles;
+    handles.reserve( records.utf8_count() );
+
+    for ( size_t i = 0; i < records.utf8_count(); ++i )
+    {
+        handles.push_back( utf8_intern( records[i] ) );
+    }
+
+    return handles;
+}
+
+
+UTF8interner::handle UTF8interner::utf8_lookup( const UTF8string_view& str ) const noexcept
+{
+    return handle( utf8_find_( str.utf8_data(), str.utf8_size(), str.hash() ) );
+}
+
+
+size_t UTF8interner::utf8_count() const noexcept
+{
+    return _utf8count;
+}
+
+UTF8interner::usage UTF8interner::utf8_usage() const noexcept
+{
+    return usage{ _utf8count, _utf8bytes, _utf8allocated, _utf8table.capacity() * sizeof( const Entry * ) };
+}
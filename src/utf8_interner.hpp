@@ -0,0 +1,272 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#ifndef UTF8_INTERNER_HPP_INCLUDED
+#define UTF8_INTERNER_HPP_INCLUDED
+
+/**
+*   @file utf8_interner.hpp
+*   @brief This is a UTF-8 string library header
+*/
+
+#include "utf8_string.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class UTF8records;
+
+/**
+*   @class UTF8interner final
+*   @brief Table of unique UTF-8 strings
+*
+*   This class stores each distinct string once and gives a handle to it.
+*   The strings are copied into large blocks of memory, next to their
+*   hash value and their length, so interning a string does not allocate
+*   memory most of the time. The strings live as long as the table.
+*
+*   Two handles of the same table are equal if and only if they refer
+*   to the same string, so they are compared in constant time.
+*/
+class UTF8interner final
+{
+    struct Entry
+    {
+        size_t hash;
+        size_t size;
+        size_t length;
+    };
+
+public:
+
+    /**
+    *   @class handle final
+    *   @brief Handle of an interned string
+    *
+    *   A handle is a pointer to a string of the table, it is valid
+    *   as long as the table exists. A default handle refers to nothing.
+    */
+    class handle final
+    {
+        const Entry * _entry = nullptr;
+
+        explicit handle( const Entry * entry ) noexcept : _entry( entry ) {}
+
+        friend class UTF8interner;
+
+    public:
+
+        /**
+        *   @fn handle() noexcept
+        *   Build a handle that refers to nothing
+        */
+        handle() noexcept = default;
+
+        /**
+        *   @fn explicit operator bool() const noexcept
+        *   @return TRUE if the handle refers to a string, FALSE otherwise
+        */
+        explicit operator bool() const noexcept
+        {
+            return _entry != nullptr;
+        }
+        /**
+        *   @fn UTF8string_view utf8_view() const noexcept
+        *   @return A view of the interned string
+        *   @pre The handle refers to a string
+        */
+        UTF8string_view utf8_view() const noexcept
+        {
+            return utf8_view_( _entry );
+        }
+        /**
+        *   @fn size_t hash() const noexcept
+        *   @return The hash value of the string, computed when it was interned
+        *           (the same as the one of a UTF8string with the same content)
+        *   @pre The handle refers to a string
+        */
+        size_t hash() const noexcept
+        {
+            return _entry->hash;
+        }
+
+        /**
+        *   @fn friend bool operator ==(const handle& h1, const handle& h2) noexcept
+        *   @return TRUE if they refer to the same string, FALSE otherwise
+        *   @note The strings are not compared, only the handles.
+        */
+        friend bool operator ==( const handle& h1, const handle& h2 ) noexcept
+        {
+            return h1._entry == h2._entry;
+        }
+        /**
+        *   @fn friend bool operator !=(const handle& h1, const handle& h2) noexcept
+        */
+        friend bool operator !=( const handle& h1, const handle& h2 ) noexcept
+        {
+            return h1._entry != h2._entry;
+        }
+        /**
+        *   @fn friend bool operator <(const handle& h1, const handle& h2) noexcept
+        *   Arbitrary order of the handles, to put them into ordered containers
+        *   @note This is not the order of the strings
+        */
+        friend bool operator <( const handle& h1, const handle& h2 ) noexcept
+        {
+            return std::less<const void *>()( h1._entry, h2._entry );
+        }
+    };
+
+    /**
+    *   @struct usage
+    *   @brief Memory used by the table
+    */
+    struct usage
+    {
+        /// Number of distinct strings
+        size_t strings;
+        /// Size of the strings (in bytes)
+        size_t string_bytes;
+        /// Memory allocated for the strings and their entries (in bytes)
+        size_t block_bytes;
+        /// Memory allocated for the hash table (in bytes)
+        size_t table_bytes;
+    };
+
+private:
+
+    std::vector<std::unique_ptr<char[]>> _utf8blocks = {};
+    char * _utf8cursor = nullptr;
+    size_t _utf8available = 0U;
+    size_t _utf8allocated = 0U;
+    size_t _utf8bytes = 0U;
+    size_t _utf8count = 0U;
+    // Open addressing, the size is a power of two
+    std::vector<const Entry *> _utf8table = {};
+    unsigned _utf8shift = 0U;
+
+    static UTF8string_view utf8_view_( const Entry * entry ) noexcept;
+    size_t utf8_slot_( const size_t hash ) const noexcept;
+    const Entry * utf8_find_( const char * data, const size_t size, const size_t hash ) const noexcept;
+    const Entry * utf8_store_( const UTF8string_view& str, const size_t hash );
+    void utf8_rehash_( const size_t count );
+    handle utf8_intern_( const UTF8string_view& str, const size_t hash );
+
+public:
+
+    /**
+    *   @fn UTF8interner() = default
+    */
+    UTF8interner() = default;
+
+    UTF8interner( const UTF8interner& ) = delete;
+    UTF8interner& operator =( const UTF8interner& ) = delete;
+
+    /**
+    *   @fn UTF8interner(UTF8interner&& interner) noexcept
+    *   The handles given by *interner* stay valid, *interner* is empty after the call
+    */
+    UTF8interner( UTF8interner&& interner ) noexcept;
+    /**
+    *   @fn UTF8interner& operator =(UTF8interner&& interner) noexcept
+    *   The handles given by *interner* stay valid,
+    *   the ones given by the current table are no longer valid
+    */
+    UTF8interner& operator =( UTF8interner&& interner ) noexcept;
+
+    /**
+    *   @fn void utf8_reserve(const size_t count)
+    *   Prepare the table for a number of distinct strings
+    *   @param count The expected number of distinct strings
+    */
+    void utf8_reserve( const size_t count );
+
+    /**
+    *   @fn handle utf8_intern(const UTF8string_view& str)
+    *
+    *   Get the handle of a string, the string is stored
+    *   if it is not in the table yet.
+    *
+    *   @param str The string
+    *   @return The handle of the string in the table
+    */
+    handle utf8_intern( const UTF8string_view& str );
+    /**
+    *   @fn handle utf8_intern(const UTF8string& str)
+    *   Same as utf8_intern(const UTF8string_view&),
+    *   the hash value of the string is not computed again
+    *   @param str The string
+    *   @return The handle of the string in the table
+    */
+    handle utf8_intern( const UTF8string& str );
+    /**
+    *   @fn std::vector<handle> utf8_intern(const std::vector<UTF8string>& strings)
+    *   Intern every string of a list
+    *   @param strings The strings
+    *   @return The handles, in the same order as the strings
+    */
+    std::vector<handle> utf8_intern( const std::vector<UTF8string>& strings );
+    /**
+    *   @fn std::vector<handle> utf8_intern(const std::vector<UTF8string_view>& strings)
+    *   Intern every string of a list
+    *   @param strings The strings
+    *   @return The handles, in the same order as the strings
+    */
+    std::vector<handle> utf8_intern( const std::vector<UTF8string_view>& strings );
+    /**
+    *   @fn std::vector<handle> utf8_intern(const UTF8records& records)
+    *   Intern every record of a table
+    *   @param records The records
+    *   @return The handles, in the same order as the records
+    */
+    std::vector<handle> utf8_intern( const UTF8records& records );
+
+    /**
+    *   @fn handle utf8_lookup(const UTF8string_view& str) const noexcept
+    *   @param str The string
+    *   @return The handle of the string, a handle that refers
+    *           to nothing if the string is not in the table
+    */
+    handle utf8_lookup( const UTF8string_view& str ) const noexcept;
+
+    /**
+    *   @fn size_t utf8_count() const noexcept
+    *   @return The number of distinct strings in the table
+    */
+    size_t utf8_count() const noexcept;
+    /**
+    *   @fn usage utf8_usage() const noexcept
+    *   @return The memory used by the table
+    */
+    usage utf8_usage() const noexcept;
+
+    ~UTF8interner() = default;
+};
+
+
+namespace std
+{
+
+template<>
+class hash<UTF8interner::handle>
+{
+public:
+    size_t operator()( const UTF8interner::handle& h ) const noexcept
+    {
+        return h ? h.hash() : 0U;
+    }
+};
+
+}
+
+#endif // UTF8_INTERNER_HPP_INCLUDED
@@ -15,25 +15,44 @@
 #include <stdexcept>
 
 
-UTF8iterator::UTF8iterator( const UTF8string& u ) noexcept
-    : _index( 0 ), _data( u ) {}
-
-UTF8iterator::UTF8iterator( const UTF8iterator& it ) noexcept
-    : _index( it._index ), _data( it._data ) {}
+namespace
+{
 
+inline bool is_continuation( const char c ) noexcept
+{
+    return ( 0xc0 & static_cast<unsigned char>( c ) ) == 0x80;
+}
 
-UTF8iterator& UTF8iterator::operator =( const UTF8iterator& it ) noexcept
+// Memory size of the codepoint starting with the byte c (in byte)
+inline size_t codepoint_len( const char c ) noexcept
 {
-    _data = it._data;
-    _index = it._index;
-    return *this;
+    const unsigned char byte = static_cast<unsigned char>( c );
+
+    if ( 0xf0 == ( 0xf8 & byte ) )
+        return 4;
+    else if ( 0xe0 == ( 0xf0 & byte ) )
+        return 3;
+    else if ( 0xc0 == ( 0xe0 & byte ) )
+        return 2;
+    else
+        return 1;
+}
+
 }
 
 
+UTF8iterator::UTF8iterator( const char * data, const size_t size,
+                            const size_t bpos, const size_t index ) noexcept
+    : _data( data ), _size( size ), _bpos( bpos ), _index( index ) {}
+
+
 UTF8iterator& UTF8iterator::operator ++() noexcept
 {
-    if ( _index < _data.utf8_length() )
+    if ( _bpos < _size )
+    {
+        _bpos += codepoint_len( _data[_bpos] );
         _index += 1;
+    }
 
     return *this;
 }
@@ -42,18 +61,24 @@ UTF8iterator& UTF8iterator::operator ++() noexcept
 UTF8iterator UTF8iterator::operator ++( int ) noexcept
 {
     UTF8iterator oldit( *this );
-
-    if ( _index < _data.utf8_length() )
-        _index += 1;
-
+    ++( *this );
     return oldit;
 }
 
 
 UTF8iterator& UTF8iterator::operator --() noexcept
 {
-    if ( _index > 0 )
+    if ( _bpos > 0 )
+    {
+        // Go back to the first byte of the previous codepoint
+        do
+        {
+            _bpos -= 1;
+        }
+        while ( _bpos > 0 && is_continuation( _data[_bpos] ) );
+
         _index -= 1;
+    }
 
     return *this;
 }
@@ -62,17 +87,14 @@ UTF8iterator& UTF8iterator::operator --() noexcept
 UTF8iterator UTF8iterator::operator --( int ) noexcept
 {
     UTF8iterator oldit( *this );
-
-    if ( _index > 0 )
-        _index -= 1;
-
+    --( *this );
     return oldit;
 }
 
 
 bool UTF8iterator::operator ==( const UTF8iterator& it ) const noexcept
 {
-    return ( _data == it._data ) && ( _index == it._index );
+    return ( _data == it._data ) && ( _bpos == it._bpos );
 }
 
 
@@ -84,39 +106,41 @@ bool UTF8iterator::operator !=( const UTF8iterator& it ) const noexcept
 
 bool UTF8iterator::operator <( const UTF8iterator& it ) const noexcept
 {
-    return ( _data == it._data ) && ( _index < it._index );
+    return ( _data == it._data ) && ( _bpos < it._bpos );
 }
 
 bool UTF8iterator::operator >( const UTF8iterator& it ) const noexcept
 {
-    return ( _data == it._data ) && ( _index > it._index );
+    return ( _data == it._data ) && ( _bpos > it._bpos );
 }
 
 bool UTF8iterator::operator <=( const UTF8iterator& it ) const noexcept
 {
-    return ( _data == it._data ) && ( _index <= it._index );
+    return ( _data == it._data ) && ( _bpos <= it._bpos );
 }
 
 bool UTF8iterator::operator >=( const UTF8iterator& it ) const noexcept
 {
-    return ( _data == it._data ) && ( _index >= it._index );
+    return ( _data == it._data ) && ( _bpos >= it._bpos );
 }
 
-const UTF8string::u8char UTF8iterator::operator *() const
+const UTF8char UTF8iterator::operator *() const
 {
-    return _data.utf8_at( _index );
+    if ( _bpos >= _size )
+        throw std::out_of_range( "the iterator does not point to a codepoint" );
+
+    return UTF8char( _data + _bpos, codepoint_len( _data[_bpos] ) );
 }
 
 
 UTF8iterator UTF8iterator::operator +( const size_t n ) const noexcept
 {
     UTF8iterator newit( *this );
-    const size_t U8LEN = newit._data.utf8_length();
 
-    if ( newit._index + n < U8LEN )
-        newit._index += n;
-    else
-        newit._index = U8LEN;
+    for ( size_t i = 0; i < n && newit._bpos < newit._size; ++i )
+    {
+        ++newit;
+    }
 
     return newit;
 }
@@ -126,18 +150,18 @@ UTF8iterator UTF8iterator::operator -( const size_t n ) const noexcept
 {
     UTF8iterator newit( *this );
 
-    if ( newit._index >= n )
-        newit._index -= n;
-    else
-        newit._index = 0;
+    for ( size_t i = 0; i < n && newit._bpos > 0; ++i )
+    {
+        --newit;
+    }
 
     return newit;
 }
 
-long UTF8iterator::operator -( const UTF8iterator& it ) const
+UTF8iterator::difference_type UTF8iterator::operator -( const UTF8iterator& it ) const
 {
     if ( _data != it._data )
         throw std::invalid_argument( "iterators don't point to the same data" );
 
-    return static_cast<long>( _index ) - static_cast<long>( it._index );
+    return static_cast<difference_type>( _index ) - static_cast<difference_type>( it._index );
 }
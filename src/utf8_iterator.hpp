@@ -18,38 +18,90 @@
 *   @brief This is a UTF-8 string library header
 */
 
-class UTF8string;
+#include <iterator>
+#include <cstddef>
+
+template <typename Allocator> class UTF8basic_string;
+class UTF8char;
 
 
 /**
 *   @class UTF8iterator final
 *   @brief Iterator on UTF8 string
 *
-*   This class defines the iterator of UTF-8 string
+*   This class defines the iterator of UTF-8 string.
+*
+*   The iterator does not own the string, it points to its content
+*   and keeps the current position (in bytes and in codepoints).
+*   Any modification of the string invalidates the iterator.
 */
 class UTF8iterator final
 {
+    const char * _data = nullptr;
+    size_t _size  = 0;
+    size_t _bpos  = 0;
     size_t _index = 0;
-    UTF8string _data;
+
+    UTF8iterator( const char * data, const size_t size,
+                  const size_t bpos, const size_t index ) noexcept;
 
     char& operator ->() = delete;
 
+    template <typename> friend class UTF8basic_string;
+    friend class UTF8string_view;
+    friend class UTF8searcher;
+
 public:
 
-    UTF8iterator() = delete;
+    /**
+    *   @typedef iterator_category
+    *   @brief Input iterator
+    *
+    *   The iterator can also move backward, but operator *() returns
+    *   the codepoint by value, so it does not meet the requirements
+    *   of a forward iterator.
+    */
+    using iterator_category = std::input_iterator_tag;
+    /**
+    *   @typedef value_type
+    *   @brief The UTF-8 character
+    */
+    using value_type = UTF8char;
+    /**
+    *   @typedef difference_type
+    *   @brief The difference between two iterators (in number of codepoints)
+    */
+    using difference_type = std::ptrdiff_t;
+    /**
+    *   @typedef pointer
+    */
+    using pointer = const value_type *;
+    /**
+    *   @typedef reference
+    *   @brief The type returned by operator *() (a copy of the codepoint)
+    */
+    using reference = const value_type;
+
+    /**
+    *   @fn UTF8iterator() noexcept
+    *   Build a singular iterator that does not point to any string
+    */
+    UTF8iterator() noexcept = default;
 
     /**
-    *   @fn explicit UTF8iterator(const UTF8string& u) noexcept
+    *   @fn template <typename Allocator> explicit UTF8iterator(const UTF8basic_string<Allocator>& u) noexcept
     *   Build an iterator object using a UTF8string object
     *   @param u utf-8 string
     */
-    explicit UTF8iterator( const UTF8string& u ) noexcept;
+    template <typename Allocator>
+    explicit UTF8iterator( const UTF8basic_string<Allocator>& u ) noexcept
+        : _data( u.utf8_str() ), _size( u.utf8_size() ), _bpos( 0 ), _index( 0 ) {}
 
     /**
     *   @fn UTF8iterator(const UTF8iterator& it) noexcept
     *   @param it The iterator to copy
     */
-    UTF8iterator( const UTF8iterator& it ) noexcept;
+    UTF8iterator( const UTF8iterator& it ) noexcept = default;
 
     /**
     *   @fn UTF8iterator& operator ++() noexcept
@@ -89,7 +141,7 @@ public:
     *   @param it The iterator that wille be assigned
     *   @return The same iterator as the argument
     */
-    UTF8iterator& operator =( const UTF8iterator& it ) noexcept;
+    UTF8iterator& operator =( const UTF8iterator& it ) noexcept = default;
 
     /**
     *   @fn bool operator ==(const UTF8iterator& it) const noexcept
@@ -143,6 +195,7 @@ public:
     *   Returns an iterator which has been moved n positions forward
     *
     *   @param n the number of step to move forward
+    *   @note This function runs in O(n)
     *   @return The same iterator that moved forward
     */
     UTF8iterator operator +( const size_t n ) const noexcept;
@@ -152,24 +205,25 @@ public:
     *   Returns an iterator which has been moved n positions backward
     *
     *   @param n the number of steps to move backward
+    *   @note This function runs in O(n)
     *   @return The same iterator that moved backward
     */
     UTF8iterator operator -( const size_t n ) const noexcept;
     /**
-    *   @fn long operator -(const UTF8iterator& it) const
+    *   @fn difference_type operator -(const UTF8iterator& it) const
     *
     *   Return the difference value between *this and it
     *
     *   @param it
-    *   @return A long value *n* such that it + n = *this
+    *   @return A value *n* such that it + n = *this
     *   @pre *this and it points to the same data
     *   @post *this == it + (*this - it)
     *   @exception std::invalid_argument if the pre-condition is not satisfied
     */
-    long operator -( const UTF8iterator& it ) const;
+    difference_type operator -( const UTF8iterator& it ) const;
 
     /**
-    *   @fn const UTF8string::u8char operator *() const
+    *   @fn const UTF8char operator *() const
     *
     *   Dereferences the pointer returning the codepoint
     *   pointed by the iterator at its current potision
@@ -178,7 +232,7 @@ public:
     *   @note This function will throw an *std::out_of_range* exception
     *         if the iterator does not point to a codepoint
     */
-    const UTF8string::u8char operator *() const;
+    const UTF8char operator *() const;
 
     ~UTF8iterator() = default;
 };
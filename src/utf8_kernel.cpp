@@ -0,0 +1,1379 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#include "utf8_kernel.hpp"
+
+#include <cstring>
+#include <cstdint>
+
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define UTF8_KERNEL_X86 1
+#include <immintrin.h>
+#else
+#define UTF8_KERNEL_X86 0
+#endif
+
+
+namespace
+{
+
+using byte_t = unsigned char;
+using utf8_kernel::npos;
+
+size_t length_scalar( const char * data, size_t size ) noexcept
+{
+    const byte_t * it = reinterpret_cast<const byte_t *>( data );
+    const byte_t * const ITEND = it + size;
+    size_t len = 0;
+
+    while ( it < ITEND )
+    {
+        if ( ( 0xF8 & *it ) == 0xF0 && *it <= 0xF4 )
+        {
+            // The UTF-8 codepoint begin with 0b11110xxx -> 4-byte codepoint
+            // If the iterator reach the end of the string before the
+            // end of the 4-byte codepoint -> invalid string
+            if ( ITEND - it < 4 )
+                return npos;
+
+            // Each of the following bytes is a value
+            // between 0x80 and 0xBF
+            if ( ( ( 0xC0 & *( it + 1 ) ) != 0x80 ) || ( ( 0xC0 & *( it + 2 ) ) != 0x80 )
+                    || ( ( 0xC0 & *( it + 3 ) ) != 0x80 ) )
+            {
+                return npos;
+            }
+
+            // If the first byte of the sequence is 0xF0
+            // then the first continuation byte must be between 0x90 and 0xBF
+            // otherwise, if the byte is 0xF4
+            // then the first continuation byte must be between 0x80 and 0x8F
+            if ( *it == 0xF0 )
+            {
+                if ( *( it + 1 ) < 0x90 || *( it + 1 ) > 0xBF )
+                    return npos;
+            }
+            else if ( *it == 0xF4 )
+            {
+                if ( *( it + 1 ) < 0x80 || *( it + 1 ) > 0x8F )
+                    return npos;
+            }
+
+            it += 4;    // Jump to the next codepoint
+        }
+        else if ( ( 0xF0 & *it ) == 0xE0 )
+        {
+            // The UTF-8 codepoint begin with 0b1110xxxx -> 3-byte codepoint
+            if ( ITEND - it < 3 )
+                return npos;
+
+            // Each of the following bytes starts with
+            // 0b10xxxxxx in a valid string
+            if ( ( ( 0xC0 & *( it + 1 ) ) != 0x80 ) || ( ( 0xC0 & *( it + 2 ) ) != 0x80 ) )
+                return npos;
+
+            // If the first byte of the sequence is 0xE0
+            // then the first continuation byte must be between 0xA0 and 0xBF
+            // otherwise, if the byte is 0xED
+            // then the first continuation byte must be between 0x80 and 0x9F
+            if ( *it == 0xE0 )
+            {
+                if ( *( it + 1 ) < 0xA0 || *( it + 1 ) > 0xBF )
+                    return npos;
+            }
+            else if ( *it == 0xED )
+            {
+                if ( *( it + 1 ) > 0x9F )
+                    return npos;
+            }
+
+            it += 3;
+        }
+        else if ( ( 0xE0 & *it ) == 0xC0 )
+        {
+            // The UTF-8 codepoint begin with 0b110xxxxx -> 2-byte codepoint
+            // 0xC0 and 0xC1 can only start an overlong encoding
+            if ( *it < 0xC2 || ITEND - it < 2 )
+                return npos;
+
+            // The following byte starts with 0b10xxxxxx in a valid string
+            if ( ( 0xC0 & *( it + 1 ) ) != 0x80 )
+                return npos;
+
+            it += 2;
+        }
+        else if ( ( 0x80 & *it ) == 0x00 )
+        {
+            // The UTF-8 codepoint begin with 0b0xxxxxxx -> 1-byte codepoint
+            it += 1;
+        }
+        else
+        {
+            // Invalid codepoint
+            return npos;
+        }
+
+        len += 1;
+    }
+
+    return len;
+}
+
+// memchr() looks for the first byte, memcmp() checks the candidates
+size_t find_scalar( const char * data, size_t size, const char * needle, size_t nsize,
+                    size_t ) noexcept
+{
+    if ( nsize > size )
+        return npos;
+
+    const char * p = data;
+    const char * const LAST = data + ( size - nsize );
+
+    while ( p <= LAST )
+    {
+        p = static_cast<const char *>( std::memchr( p, needle[0], static_cast<size_t>( LAST - p ) + 1 ) );
+
+        if ( p == nullptr )
+            break;
+
+        if ( std::memcmp( p + 1, needle + 1, nsize - 1 ) == 0 )
+            return static_cast<size_t>( p - data );
+
+        ++p;
+    }
+
+    return npos;
+}
+
+
+// Decode the codepoint at p in a valid sequence, p moves to the next codepoint
+inline char32_t decode_next( const byte_t *& p ) noexcept
+{
+    const byte_t B = *p;
+
+    if ( B < 0x80 )
+    {
+        p += 1;
+        return B;
+    }
+    else if ( B < 0xE0 )
+    {
+        const char32_t C = ( char32_t( B & 0x1F ) << 6 ) | char32_t( p[1] & 0x3F );
+        p += 2;
+        return C;
+    }
+    else if ( B < 0xF0 )
+    {
+        const char32_t C = ( char32_t( B & 0x0F ) << 12 ) | ( char32_t( p[1] & 0x3F ) << 6 )
+                           | char32_t( p[2] & 0x3F );
+        p += 3;
+        return C;
+    }
+
+    const char32_t C = ( char32_t( B & 0x07 ) << 18 ) | ( char32_t( p[1] & 0x3F ) << 12 )
+                       | ( char32_t( p[2] & 0x3F ) << 6 ) | char32_t( p[3] & 0x3F );
+    p += 4;
+    return C;
+}
+
+// Encode a valid codepoint, out moves after the bytes
+inline void encode_next( const char32_t c, char *& out ) noexcept
+{
+    if ( c < 0x80 )
+    {
+        *out++ = static_cast<char>( c );
+    }
+    else if ( c < 0x800 )
+    {
+        *out++ = static_cast<char>( 0xC0 | ( c >> 6 ) );
+        *out++ = static_cast<char>( 0x80 | ( c & 0x3F ) );
+    }
+    else if ( c < 0x10000 )
+    {
+        *out++ = static_cast<char>( 0xE0 | ( c >> 12 ) );
+        *out++ = static_cast<char>( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+        *out++ = static_cast<char>( 0x80 | ( c & 0x3F ) );
+    }
+    else
+    {
+        *out++ = static_cast<char>( 0xF0 | ( c >> 18 ) );
+        *out++ = static_cast<char>( 0x80 | ( ( c >> 12 ) & 0x3F ) );
+        *out++ = static_cast<char>( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+        *out++ = static_cast<char>( 0x80 | ( c & 0x3F ) );
+    }
+}
+
+// A codepoint out of the BMP is written as a surrogate pair
+inline void put_u16( const char32_t c, char16_t *& out ) noexcept
+{
+    if ( c < 0x10000 )
+    {
+        *out++ = static_cast<char16_t>( c );
+    }
+    else
+    {
+        *out++ = static_cast<char16_t>( 0xD800 + ( ( c - 0x10000 ) >> 10 ) );
+        *out++ = static_cast<char16_t>( 0xDC00 + ( ( c - 0x10000 ) & 0x3FF ) );
+    }
+}
+
+// Read a codepoint of a valid UTF-16 sequence, i moves to the next one
+inline char32_t get_u16( const char16_t * in, size_t& i ) noexcept
+{
+    const char32_t C = in[i++];
+
+    if ( C < 0xD800 || C > 0xDBFF )
+        return C;
+
+    return 0x10000 + ( ( C - 0xD800 ) << 10 ) + ( char32_t( in[i++] ) - 0xDC00 );
+}
+
+size_t decode_u32_scalar( const char * data, size_t size, char32_t * out ) noexcept
+{
+    const byte_t * p = reinterpret_cast<const byte_t *>( data );
+    const byte_t * const END = p + size;
+    char32_t * o = out;
+
+    while ( p < END )
+        *o++ = decode_next( p );
+
+    return static_cast<size_t>( o - out );
+}
+
+size_t decode_u16_scalar( const char * data, size_t size, char16_t * out ) noexcept
+{
+    const byte_t * p = reinterpret_cast<const byte_t *>( data );
+    const byte_t * const END = p + size;
+    char16_t * o = out;
+
+    while ( p < END )
+        put_u16( decode_next( p ), o );
+
+    return static_cast<size_t>( o - out );
+}
+
+size_t encode_u32_scalar( const char32_t * in, size_t n, char * out ) noexcept
+{
+    char * o = out;
+
+    for ( size_t i = 0; i < n; ++i )
+        encode_next( in[i], o );
+
+    return static_cast<size_t>( o - out );
+}
+
+size_t encode_u16_scalar( const char16_t * in, size_t n, char * out ) noexcept
+{
+    char * o = out;
+    size_t i = 0;
+
+    while ( i < n )
+        encode_next( get_u16( in, i ), o );
+
+    return static_cast<size_t>( o - out );
+}
+
+utf8_kernel::block_masks classify_scalar( const char * data, size_t size, const char delim ) noexcept
+{
+    utf8_kernel::block_masks masks = { 0U, 0U };
+
+    for ( size_t i = 0; i < size; ++i )
+    {
+        const std::uint64_t BIT = std::uint64_t( 1 ) << i;
+
+        if ( data[i] == delim )
+            masks.delims |= BIT;
+
+        if ( ( static_cast<byte_t>( data[i] ) & 0xC0 ) != 0x80 )
+            masks.starts |= BIT;
+    }
+
+    return masks;
+}
+
+
+#if UTF8_KERNEL_X86
+
+/*
+    Vectorized validation (lookup algorithm from Keiser & Lemire,
+    "Validating UTF-8 In Less Than One Instruction Per Byte").
+
+    Every byte is classified according to its high nibble, the high nibble
+    and the low nibble of the previous byte. The three lookups are ANDed,
+    any bit left set is an error, except for the 3rd and 4th bytes
+    of a sequence, which are checked separately.
+*/
+constexpr char TOO_SHORT   = 1 << 0;
+constexpr char TOO_LONG    = 1 << 1;
+constexpr char OVERLONG_3  = 1 << 2;
+constexpr char TOO_LARGE   = 1 << 3;
+constexpr char SURROGATE   = 1 << 4;
+constexpr char OVERLONG_2  = 1 << 5;
+constexpr char TOO_LARGE_1000 = 1 << 6;
+constexpr char OVERLONG_4  = 1 << 6;
+constexpr char TWO_CONTS   = static_cast<char>( 1 << 7 );
+constexpr char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+constexpr char byte_( unsigned v )
+{
+    return static_cast<char>( v );
+}
+
+// Classification of the previous byte (high nibble)
+#define UTF8_BYTE_1_HIGH \
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, \
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, \
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, \
+    TOO_SHORT | OVERLONG_2, \
+    TOO_SHORT, \
+    TOO_SHORT | OVERLONG_3 | SURROGATE, \
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+
+// Classification of the previous byte (low nibble)
+#define UTF8_BYTE_1_LOW \
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, \
+    CARRY | OVERLONG_2, \
+    CARRY, \
+    CARRY, \
+    CARRY | TOO_LARGE, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000, \
+    CARRY | TOO_LARGE | TOO_LARGE_1000
+
+// Classification of the current byte (high nibble)
+#define UTF8_BYTE_2_HIGH \
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, \
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, \
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, \
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE, \
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE  | TOO_LARGE, \
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE  | TOO_LARGE, \
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+
+// A sequence is incomplete if one of the last three bytes
+// of the block starts a codepoint that is longer than the remaining bytes
+#define UTF8_MAX_VALUE_16 \
+    byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), \
+    byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), \
+    byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), \
+    byte_( 0xFF ), byte_( 0xEF ), byte_( 0xDF ), byte_( 0xBF )
+
+
+struct SSEState
+{
+    __m128i error;
+    __m128i prev_input;
+    __m128i prev_incomplete;
+};
+
+__attribute__( ( target( "sse4.2" ) ) )
+inline __m128i sse_shr4_( const __m128i v ) noexcept
+{
+    return _mm_and_si128( _mm_srli_epi16( v, 4 ), _mm_set1_epi8( 0x0F ) );
+}
+
+// Check a block, return the number of codepoints starting in it
+__attribute__( ( target( "sse4.2" ) ) )
+inline size_t sse_check_block_( SSEState& st, const __m128i input ) noexcept
+{
+    size_t count = 16;
+
+    if ( _mm_movemask_epi8( input ) == 0 )
+    {
+        // ASCII block, only a sequence left over from the previous block
+        // can be an error
+        st.error = _mm_or_si128( st.error, st.prev_incomplete );
+        st.prev_incomplete = _mm_setzero_si128();
+    }
+    else
+    {
+        const __m128i prev1 = _mm_alignr_epi8( input, st.prev_input, 15 );
+        const __m128i prev2 = _mm_alignr_epi8( input, st.prev_input, 14 );
+        const __m128i prev3 = _mm_alignr_epi8( input, st.prev_input, 13 );
+
+        const __m128i byte_1_high = _mm_shuffle_epi8( _mm_setr_epi8( UTF8_BYTE_1_HIGH ),
+                                                      sse_shr4_( prev1 ) );
+        const __m128i byte_1_low  = _mm_shuffle_epi8( _mm_setr_epi8( UTF8_BYTE_1_LOW ),
+                                                      _mm_and_si128( prev1, _mm_set1_epi8( 0x0F ) ) );
+        const __m128i byte_2_high = _mm_shuffle_epi8( _mm_setr_epi8( UTF8_BYTE_2_HIGH ),
+                                                      sse_shr4_( input ) );
+        const __m128i special = _mm_and_si128( _mm_and_si128( byte_1_high, byte_1_low ),
+                                               byte_2_high );
+
+        // 3rd and 4th bytes of a sequence must be continuation bytes
+        const __m128i is_third  = _mm_subs_epu8( prev2, _mm_set1_epi8( 0xE0 - 0x80 ) );
+        const __m128i is_fourth = _mm_subs_epu8( prev3, _mm_set1_epi8( 0xF0 - 0x80 ) );
+        const __m128i must23_80 = _mm_and_si128( _mm_or_si128( is_third, is_fourth ),
+                                                 _mm_set1_epi8( byte_( 0x80 ) ) );
+
+        st.error = _mm_or_si128( st.error, _mm_xor_si128( must23_80, special ) );
+        st.prev_incomplete = _mm_subs_epu8( input, _mm_setr_epi8( UTF8_MAX_VALUE_16 ) );
+
+        // Every byte that is not a continuation byte (0x80-0xBF) starts a codepoint
+        const __m128i starts = _mm_cmpgt_epi8( input, _mm_set1_epi8( byte_( 0xBF ) ) );
+        count = utf8_kernel::popcount( static_cast<std::uint32_t>( _mm_movemask_epi8( starts ) ) );
+    }
+
+    st.prev_input = input;
+    return count;
+}
+
+__attribute__( ( target( "sse4.2" ) ) )
+size_t length_sse42( const char * data, size_t size ) noexcept
+{
+    SSEState st = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+    size_t len = 0;
+    size_t i = 0;
+
+    for ( ; i + 16 <= size; i += 16 )
+    {
+        len += sse_check_block_( st, _mm_loadu_si128( reinterpret_cast<const __m128i *>( data + i ) ) );
+    }
+
+    if ( i < size )
+    {
+        // The tail is padded with ASCII bytes, they are not counted
+        char tail[16] = {0};
+        std::memcpy( tail, data + i, size - i );
+        len += sse_check_block_( st, _mm_loadu_si128( reinterpret_cast<const __m128i *>( tail ) ) );
+        len -= 16 - ( size - i );
+    }
+
+    st.error = _mm_or_si128( st.error, st.prev_incomplete );
+    return _mm_testz_si128( st.error, st.error ) != 0 ? len : npos;
+}
+
+
+struct AVXState
+{
+    __m256i error;
+    __m256i prev_input;
+    __m256i prev_incomplete;
+};
+
+__attribute__( ( target( "avx2" ) ) )
+inline __m256i avx_shr4_( const __m256i v ) noexcept
+{
+    return _mm256_and_si256( _mm256_srli_epi16( v, 4 ), _mm256_set1_epi8( 0x0F ) );
+}
+
+__attribute__( ( target( "avx2" ) ) )
+inline __m256i avx_table_( const __m128i t ) noexcept
+{
+    return _mm256_broadcastsi128_si256( t );
+}
+
+__attribute__( ( target( "avx2" ) ) )
+inline size_t avx_check_block_( AVXState& st, const __m256i input ) noexcept
+{
+    size_t count = 32;
+
+    if ( _mm256_movemask_epi8( input ) == 0 )
+    {
+        st.error = _mm256_or_si256( st.error, st.prev_incomplete );
+        st.prev_incomplete = _mm256_setzero_si256();
+    }
+    else
+    {
+        // [ prev_input(high lane) | input(low lane) ], used to shift bytes across lanes
+        const __m256i cross = _mm256_permute2x128_si256( st.prev_input, input, 0x21 );
+        const __m256i prev1 = _mm256_alignr_epi8( input, cross, 15 );
+        const __m256i prev2 = _mm256_alignr_epi8( input, cross, 14 );
+        const __m256i prev3 = _mm256_alignr_epi8( input, cross, 13 );
+
+        const __m256i byte_1_high = _mm256_shuffle_epi8( avx_table_( _mm_setr_epi8( UTF8_BYTE_1_HIGH ) ),
+                                                         avx_shr4_( prev1 ) );
+        const __m256i byte_1_low  = _mm256_shuffle_epi8( avx_table_( _mm_setr_epi8( UTF8_BYTE_1_LOW ) ),
+                                                         _mm256_and_si256( prev1, _mm256_set1_epi8( 0x0F ) ) );
+        const __m256i byte_2_high = _mm256_shuffle_epi8( avx_table_( _mm_setr_epi8( UTF8_BYTE_2_HIGH ) ),
+                                                         avx_shr4_( input ) );
+        const __m256i special = _mm256_and_si256( _mm256_and_si256( byte_1_high, byte_1_low ),
+                                                  byte_2_high );
+
+        const __m256i is_third  = _mm256_subs_epu8( prev2, _mm256_set1_epi8( 0xE0 - 0x80 ) );
+        const __m256i is_fourth = _mm256_subs_epu8( prev3, _mm256_set1_epi8( 0xF0 - 0x80 ) );
+        const __m256i must23_80 = _mm256_and_si256( _mm256_or_si256( is_third, is_fourth ),
+                                                    _mm256_set1_epi8( byte_( 0x80 ) ) );
+
+        st.error = _mm256_or_si256( st.error, _mm256_xor_si256( must23_80, special ) );
+
+        const __m256i max_value = _mm256_setr_epi8( byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ),
+                                                    byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ),
+                                                    byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ),
+                                                    byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ), byte_( 0xFF ),
+                                                    UTF8_MAX_VALUE_16 );
+        st.prev_incomplete = _mm256_subs_epu8( input, max_value );
+
+        const __m256i starts = _mm256_cmpgt_epi8( input, _mm256_set1_epi8( byte_( 0xBF ) ) );
+        count = utf8_kernel::popcount( static_cast<std::uint32_t>( _mm256_movemask_epi8( starts ) ) );
+    }
+
+    st.prev_input = input;
+    return count;
+}
+
+__attribute__( ( target( "avx2" ) ) )
+size_t length_avx2( const char * data, size_t size ) noexcept
+{
+    AVXState st = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+    size_t len = 0;
+    size_t i = 0;
+
+    for ( ; i + 32 <= size; i += 32 )
+    {
+        len += avx_check_block_( st, _mm256_loadu_si256( reinterpret_cast<const __m256i *>( data + i ) ) );
+    }
+
+    if ( i < size )
+    {
+        char tail[32] = {0};
+        std::memcpy( tail, data + i, size - i );
+        len += avx_check_block_( st, _mm256_loadu_si256( reinterpret_cast<const __m256i *>( tail ) ) );
+        len -= 32 - ( size - i );
+    }
+
+    st.error = _mm256_or_si256( st.error, st.prev_incomplete );
+    return _mm256_testz_si256( st.error, st.error ) != 0 ? len : npos;
+}
+
+
+/*
+    Vectorized search: the first byte of the needle and the byte at
+    the probe offset are compared with 16 (or 32) positions at once,
+    memcmp() is only called on the positions where both bytes match.
+*/
+__attribute__( ( target( "sse2" ) ) )
+size_t find_sse2( const char * data, size_t size, const char * needle, size_t nsize,
+                 size_t probe ) noexcept
+{
+    if ( nsize > size )
+        return npos;
+
+    const __m128i first = _mm_set1_epi8( needle[0] );
+    const __m128i last  = _mm_set1_epi8( needle[probe] );
+    size_t i = 0;
+
+    for ( ; i + nsize - 1 + 16 <= size; i += 16 )
+    {
+        const __m128i block_first = _mm_loadu_si128( reinterpret_cast<const __m128i *>( data + i ) );
+        const __m128i block_last  = _mm_loadu_si128( reinterpret_cast<const __m128i *>( data + i + probe ) );
+        unsigned mask = static_cast<unsigned>( _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi8( first, block_first ),
+                                                                                  _mm_cmpeq_epi8( last, block_last ) ) ) );
+        while ( mask != 0 )
+        {
+            const size_t POS = i + static_cast<size_t>( __builtin_ctz( mask ) );
+
+            if ( std::memcmp( data + POS + 1, needle + 1, nsize - 1 ) == 0 )
+                return POS;
+
+            mask &= mask - 1;
+        }
+    }
+
+    const size_t POS = find_scalar( data + i, size - i, needle, nsize, probe );
+    return POS == npos ? npos : i + POS;
+}
+
+__attribute__( ( target( "avx2" ) ) )
+size_t find_avx2( const char * data, size_t size, const char * needle, size_t nsize,
+                 size_t probe ) noexcept
+{
+    if ( nsize > size )
+        return npos;
+
+    const __m256i first = _mm256_set1_epi8( needle[0] );
+    const __m256i last  = _mm256_set1_epi8( needle[probe] );
+    size_t i = 0;
+
+    for ( ; i + nsize - 1 + 32 <= size; i += 32 )
+    {
+        const __m256i block_first = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( data + i ) );
+        const __m256i block_last  = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( data + i + probe ) );
+        unsigned mask = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_and_si256( _mm256_cmpeq_epi8( first, block_first ),
+                                                                                       _mm256_cmpeq_epi8( last, block_last ) ) ) );
+        while ( mask != 0 )
+        {
+            const size_t POS = i + static_cast<size_t>( __builtin_ctz( mask ) );
+
+            if ( std::memcmp( data + POS + 1, needle + 1, nsize - 1 ) == 0 )
+                return POS;
+
+            mask &= mask - 1;
+        }
+    }
+
+    const size_t POS = find_scalar( data + i, size - i, needle, nsize, probe );
+    return POS == npos ? npos : i + POS;
+}
+
+/*
+    Transcoding: the blocks of 16 ASCII characters are converted
+    with SSE2 (zero extension or packing), the other blocks
+    are converted one codepoint at a time.
+*/
+__attribute__( ( target( "sse2" ) ) )
+size_t decode_u32_sse2( const char * data, size_t size, char32_t * out ) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const byte_t * const BEGIN = reinterpret_cast<const byte_t *>( data );
+    char32_t * o = out;
+    size_t i = 0;
+
+    while ( i + 16 <= size )
+    {
+        const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i *>( data + i ) );
+
+        if ( _mm_movemask_epi8( block ) == 0 )
+        {
+            const __m128i lo = _mm_unpacklo_epi8( block, zero );
+            const __m128i hi = _mm_unpackhi_epi8( block, zero );
+            _mm_storeu_si128( reinterpret_cast<__m128i *>( o ), _mm_unpacklo_epi16( lo, zero ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i *>( o + 4 ), _mm_unpackhi_epi16( lo, zero ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i *>( o + 8 ), _mm_unpacklo_epi16( hi, zero ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i *>( o + 12 ), _mm_unpackhi_epi16( hi, zero ) );
+            i += 16;
+            o += 16;
+        }
+        else
+        {
+            // The last codepoint may end after the block
+            const byte_t * p = BEGIN + i;
+            const byte_t * const BEND = p + 16;
+
+            while ( p < BEND )
+                *o++ = decode_next( p );
+
+            i = static_cast<size_t>( p - BEGIN );
+        }
+    }
+
+    return static_cast<size_t>( o - out ) + decode_u32_scalar( data + i, size - i, o );
+}
+
+__attribute__( ( target( "sse2" ) ) )
+size_t decode_u16_sse2( const char * data, size_t size, char16_t * out ) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const byte_t * const BEGIN = reinterpret_cast<const byte_t *>( data );
+    char16_t * o = out;
+    size_t i = 0;
+
+    while ( i + 16 <= size )
+    {
+        const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i *>( data + i ) );
+
+        if ( _mm_movemask_epi8( block ) == 0 )
+        {
+            _mm_storeu_si128( reinterpret_cast<__m128i *>( o ), _mm_unpacklo_epi8( block, zero ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i *>( o + 8 ), _mm_unpackhi_epi8( block, zero ) );
+            i += 16;
+            o += 16;
+        }
+        else
+        {
+            const byte_t * p = BEGIN + i;
+            const byte_t * const BEND = p + 16;
+
+            while ( p < BEND )
+                put_u16( decode_next( p ), o );
+
+            i = static_cast<size_t>( p - BEGIN );
+        }
+    }
+
+    return static_cast<size_t>( o - out ) + decode_u16_scalar( data + i, size - i, o );
+}
+
+__attribute__( ( target( "sse2" ) ) )
+size_t encode_u32_sse2( const char32_t * in, size_t n, char * out ) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i high = _mm_set1_epi32( ~0x7F );
+    char * o = out;
+    size_t i = 0;
+
+    while ( i + 16 <= n )
+    {
+        const __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i *>( in + i ) );
+        const __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i *>( in + i + 4 ) );
+        const __m128i c = _mm_loadu_si128( reinterpret_cast<const __m128i *>( in + i + 8 ) );
+        const __m128i d = _mm_loadu_si128( reinterpret_cast<const __m128i *>( in + i + 12 ) );
+        const __m128i all = _mm_or_si128( _mm_or_si128( a, b ), _mm_or_si128( c, d ) );
+
+        if ( _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( all, high ), zero ) ) == 0xFFFF )
+        {
+            const __m128i bytes = _mm_packus_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i *>( o ), bytes );
+            i += 16;
+            o += 16;
+        }
+        else
+        {
+            for ( const size_t BEND = i + 16; i < BEND; ++i )
+                encode_next( in[i], o );
+        }
+    }
+
+    return static_cast<size_t>( o - out ) + encode_u32_scalar( in + i, n - i, o );
+}
+
+__attribute__( ( target( "sse2" ) ) )
+size_t encode_u16_sse2( const char16_t * in, size_t n, char * out ) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i high = _mm_set1_epi16( static_cast<short>( 0xFF80 ) );
+    char * o = out;
+    size_t i = 0;
+
+    while ( i + 16 <= n )
+    {
+        const __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i *>( in + i ) );
+        const __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i *>( in + i + 8 ) );
+
+        if ( _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( _mm_or_si128( a, b ), high ), zero ) ) == 0xFFFF )
+        {
+            _mm_storeu_si128( reinterpret_cast<__m128i *>( o ), _mm_packus_epi16( a, b ) );
+            i += 16;
+            o += 16;
+        }
+        else
+        {
+            // A surrogate pair may end after the block
+            const size_t BEND = i + 16;
+
+            while ( i < BEND )
+                encode_next( get_u16( in, i ), o );
+        }
+    }
+
+    return static_cast<size_t>( o - out ) + encode_u16_scalar( in + i, n - i, o );
+}
+
+/*
+    Classification of 64 bytes: each block of 16 bytes is compared
+    with the delimiter and with the last continuation byte (0xBF)
+*/
+__attribute__( ( target( "sse2" ) ) )
+utf8_kernel::block_masks classify_sse2( const char * data, size_t size, const char delim ) noexcept
+{
+    if ( size < 64 )
+        return classify_scalar( data, size, delim );
+
+    const __m128i delims = _mm_set1_epi8( delim );
+    const __m128i last_cont = _mm_set1_epi8( byte_( 0xBF ) );
+    utf8_kernel::block_masks masks = { 0U, 0U };
+
+    for ( unsigned k = 0; k < 4; ++k )
+    {
+        const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i *>( data + 16 * k ) );
+        const std::uint64_t D = static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpeq_epi8( block, delims ) ) );
+        const std::uint64_t S = static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpgt_epi8( block, last_cont ) ) );
+        masks.delims |= D << ( 16 * k );
+        masks.starts |= S << ( 16 * k );
+    }
+
+    return masks;
+}
+
+__attribute__( ( target( "avx2" ) ) )
+utf8_kernel::block_masks classify_avx2( const char * data, size_t size, const char delim ) noexcept
+{
+    if ( size < 64 )
+        return classify_scalar( data, size, delim );
+
+    const __m256i delims = _mm256_set1_epi8( delim );
+    const __m256i last_cont = _mm256_set1_epi8( byte_( 0xBF ) );
+    const __m256i lo = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( data ) );
+    const __m256i hi = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( data + 32 ) );
+
+    const std::uint64_t DLO = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( lo, delims ) ) );
+    const std::uint64_t DHI = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( hi, delims ) ) );
+    const std::uint64_t SLO = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_cmpgt_epi8( lo, last_cont ) ) );
+    const std::uint64_t SHI = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_cmpgt_epi8( hi, last_cont ) ) );
+
+    return utf8_kernel::block_masks{ DLO | ( DHI << 32 ), SLO | ( SHI << 32 ) };
+}
+
+#undef UTF8_BYTE_1_HIGH
+#undef UTF8_BYTE_1_LOW
+#undef UTF8_BYTE_2_HIGH
+#undef UTF8_MAX_VALUE_16
+
+#endif // UTF8_KERNEL_X86
+
+
+using length_fn = size_t ( * )( const char *, size_t );
+
+// Select the best implementation supported by the CPU
+length_fn select_length() noexcept
+{
+#if UTF8_KERNEL_X86
+    __builtin_cpu_init();
+
+    if ( __builtin_cpu_supports( "avx2" ) )
+        return length_avx2;
+
+    if ( __builtin_cpu_supports( "sse4.2" ) )
+        return length_sse42;
+#endif
+
+    return length_scalar;
+}
+
+
+using find_fn = size_t ( * )( const char *, size_t, const char *, size_t, size_t );
+
+find_fn select_find() noexcept
+{
+#if UTF8_KERNEL_X86
+    __builtin_cpu_init();
+
+    if ( __builtin_cpu_supports( "avx2" ) )
+        return find_avx2;
+
+    if ( __builtin_cpu_supports( "sse2" ) )
+        return find_sse2;
+#endif
+
+    return find_scalar;
+}
+
+
+using decode_u32_fn = size_t ( * )( const char *, size_t, char32_t * );
+using decode_u16_fn = size_t ( * )( const char *, size_t, char16_t * );
+using encode_u32_fn = size_t ( * )( const char32_t *, size_t, char * );
+using encode_u16_fn = size_t ( * )( const char16_t *, size_t, char * );
+using classify_fn = utf8_kernel::block_masks ( * )( const char *, size_t, char );
+
+bool has_sse2() noexcept
+{
+#if UTF8_KERNEL_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "sse2" ) != 0;
+#else
+    return false;
+#endif
+}
+
+#if UTF8_KERNEL_X86
+decode_u32_fn select_decode_u32() noexcept
+{
+    return has_sse2() ? decode_u32_sse2 : decode_u32_scalar;
+}
+
+decode_u16_fn select_decode_u16() noexcept
+{
+    return has_sse2() ? decode_u16_sse2 : decode_u16_scalar;
+}
+
+encode_u32_fn select_encode_u32() noexcept
+{
+    return has_sse2() ? encode_u32_sse2 : encode_u32_scalar;
+}
+
+encode_u16_fn select_encode_u16() noexcept
+{
+    return has_sse2() ? encode_u16_sse2 : encode_u16_scalar;
+}
+
+classify_fn select_classify() noexcept
+{
+    __builtin_cpu_init();
+
+    if ( __builtin_cpu_supports( "avx2" ) )
+        return classify_avx2;
+
+    return has_sse2() ? classify_sse2 : classify_scalar;
+}
+#else
+decode_u32_fn select_decode_u32() noexcept
+{
+    return decode_u32_scalar;
+}
+
+decode_u16_fn select_decode_u16() noexcept
+{
+    return decode_u16_scalar;
+}
+
+encode_u32_fn select_encode_u32() noexcept
+{
+    return encode_u32_scalar;
+}
+
+encode_u16_fn select_encode_u16() noexcept
+{
+    return encode_u16_scalar;
+}
+
+classify_fn select_classify() noexcept
+{
+    return classify_scalar;
+}
+#endif
+
+
+/*
+    Hash function: wyhash (final version 4), by Wang Yi (public domain).
+    The bytes are read 8 by 8 (48 by 48 in the main loop),
+    and mixed with 64x64 -> 128 bit multiplications.
+*/
+constexpr std::uint64_t WYSECRET[4] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+                                        0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+                                      };
+
+inline void wymum( std::uint64_t& a, std::uint64_t& b ) noexcept
+{
+#if defined( __SIZEOF_INT128__ )
+    const unsigned __int128 R = static_cast<unsigned __int128>( a ) * b;
+    a = static_cast<std::uint64_t>( R );
+    b = static_cast<std::uint64_t>( R >> 64 );
+#else
+    const std::uint64_t HA = a >> 32, HB = b >> 32, LA = a & 0xFFFFFFFFU, LB = b & 0xFFFFFFFFU;
+    const std::uint64_t RH = HA * HB, RM0 = HA * LB, RM1 = HB * LA, RL = LA * LB;
+    const std::uint64_t T = RL + ( RM0 << 32 );
+    std::uint64_t c = T < RL ? 1U : 0U;
+    const std::uint64_t LO = T + ( RM1 << 32 );
+    c += LO < T ? 1U : 0U;
+    a = LO;
+    b = RH + ( RM0 >> 32 ) + ( RM1 >> 32 ) + c;
+#endif
+}
+
+inline std::uint64_t wymix( std::uint64_t a, std::uint64_t b ) noexcept
+{
+    wymum( a, b );
+    return a ^ b;
+}
+
+inline std::uint64_t wyr8( const byte_t * p ) noexcept
+{
+    std::uint64_t v;
+    std::memcpy( &v, p, 8 );
+    return v;
+}
+
+inline std::uint64_t wyr4( const byte_t * p ) noexcept
+{
+    std::uint32_t v;
+    std::memcpy( &v, p, 4 );
+    return v;
+}
+
+inline std::uint64_t wyr3( const byte_t * p, size_t k ) noexcept
+{
+    return ( std::uint64_t( p[0] ) << 16 ) | ( std::uint64_t( p[k >> 1] ) << 8 ) | p[k - 1];
+}
+
+std::uint64_t wyhash( const byte_t * p, size_t len ) noexcept
+{
+    std::uint64_t seed = wymix( WYSECRET[0], WYSECRET[1] );
+    std::uint64_t a = 0;
+    std::uint64_t b = 0;
+
+    if ( len <= 16 )
+    {
+        if ( len >= 4 )
+        {
+            const size_t OFFSET = ( len >> 3 ) << 2;
+            a = ( wyr4( p ) << 32 ) | wyr4( p + OFFSET );
+            b = ( wyr4( p + len - 4 ) << 32 ) | wyr4( p + len - 4 - OFFSET );
+        }
+        else if ( len > 0 )
+        {
+            a = wyr3( p, len );
+        }
+    }
+    else
+    {
+        size_t i = len;
+
+        if ( i > 48 )
+        {
+            std::uint64_t see1 = seed;
+            std::uint64_t see2 = seed;
+
+            do
+            {
+                seed = wymix( wyr8( p ) ^ WYSECRET[1], wyr8( p + 8 ) ^ seed );
+                see1 = wymix( wyr8( p + 16 ) ^ WYSECRET[2], wyr8( p + 24 ) ^ see1 );
+                see2 = wymix( wyr8( p + 32 ) ^ WYSECRET[3], wyr8( p + 40 ) ^ see2 );
+                p += 48;
+                i -= 48;
+            }
+            while ( i > 48 );
+
+            seed ^= see1 ^ see2;
+        }
+
+        while ( i > 16 )
+        {
+            seed = wymix( wyr8( p ) ^ WYSECRET[1], wyr8( p + 8 ) ^ seed );
+            i -= 16;
+            p += 16;
+        }
+
+        a = wyr8( p + i - 16 );
+        b = wyr8( p + i - 8 );
+    }
+
+    a ^= WYSECRET[1];
+    b ^= seed;
+    wymum( a, b );
+    return wymix( a ^ WYSECRET[0] ^ len, b ^ WYSECRET[1] );
+}
+
+}
+
+
+namespace utf8_kernel
+{
+
+bool validate( const char * data, size_t size ) noexcept
+{
+    return length( data, size ) != npos;
+}
+
+size_t length( const char * data, size_t size ) noexcept
+{
+    static const length_fn LENGTH = select_length();
+    return LENGTH( data, size );
+}
+
+/*
+    Only called on a buffer known to be invalid, so this is a plain loop.
+    The maximal subpart follows the Unicode recommendation: it stops
+    at the first byte that cannot continue the sequence.
+*/
+invalid_sequence find_invalid( const char * data, size_t size ) noexcept
+{
+    const byte_t * const P = reinterpret_cast<const byte_t *>( data );
+    size_t i = 0;
+    size_t len = 0;
+
+    while ( i < size )
+    {
+        // Skip the ASCII characters 8 bytes at a time
+        if ( i + 8 <= size )
+        {
+            std::uint64_t w;
+            std::memcpy( &w, P + i, 8 );
+
+            if ( ( w & 0x8080808080808080ULL ) == 0 )
+            {
+                i += 8;
+                len += 8;
+                continue;
+            }
+        }
+
+        const byte_t B = P[i];
+        // Range of the first continuation byte
+        byte_t lo = 0x80;
+        byte_t hi = 0xBF;
+        size_t n = 1;
+
+        if ( B < 0x80 )
+        {
+            i += 1;
+            len += 1;
+            continue;
+        }
+        else if ( B < 0xC0 )
+            return invalid_sequence{ i, 1, len, UTF8error::UNEXPECTED_CONTINUATION };
+        else if ( B < 0xC2 )
+            return invalid_sequence{ i, 1, len, UTF8error::OVERLONG };
+        else if ( B < 0xE0 )
+            n = 2;
+        else if ( B < 0xF0 )
+        {
+            n = 3;
+            lo = B == 0xE0 ? 0xA0 : 0x80;
+            hi = B == 0xED ? 0x9F : 0xBF;
+        }
+        else if ( B < 0xF5 )
+        {
+            n = 4;
+            lo = B == 0xF0 ? 0x90 : 0x80;
+            hi = B == 0xF4 ? 0x8F : 0xBF;
+        }
+        else
+            return invalid_sequence{ i, 1, len, UTF8error::INVALID_BYTE };
+
+        if ( i + 1 >= size )
+            return invalid_sequence{ i, 1, len, UTF8error::TRUNCATED };
+
+        const byte_t C = P[i + 1];
+
+        if ( C < lo || C > hi )
+        {
+            // A continuation byte out of the range is a restricted codepoint
+            UTF8error kind = UTF8error::MISSING_CONTINUATION;
+
+            if ( ( C & 0xC0 ) == 0x80 )
+            {
+                kind = ( B == 0xE0 || B == 0xF0 ) ? UTF8error::OVERLONG
+                       : B == 0xED ? UTF8error::SURROGATE : UTF8error::TOO_LARGE;
+            }
+
+            return invalid_sequence{ i, 1, len, kind };
+        }
+
+        for ( size_t k = 2; k < n; ++k )
+        {
+            if ( i + k >= size )
+                return invalid_sequence{ i, k, len, UTF8error::TRUNCATED };
+
+            if ( ( P[i + k] & 0xC0 ) != 0x80 )
+                return invalid_sequence{ i, k, len, UTF8error::MISSING_CONTINUATION };
+        }
+
+        i += n;
+        len += 1;
+    }
+
+    return invalid_sequence{ npos, 0, len, UTF8error::NONE };
+}
+
+size_t encode( const char32_t codepoint, char * out ) noexcept
+{
+    if ( codepoint < 0x80 )
+    {
+        out[0] = static_cast<char>( codepoint );
+        return 1;
+    }
+    else if ( codepoint < 0x800 )
+    {
+        out[0] = static_cast<char>( 0xC0 | ( codepoint >> 6 ) );
+        out[1] = static_cast<char>( 0x80 | ( codepoint & 0x3F ) );
+        return 2;
+    }
+    else if ( codepoint < 0x10000 )
+    {
+        // UTF-16 surrogates are not codepoints
+        if ( codepoint >= 0xD800 && codepoint <= 0xDFFF )
+            return 0;
+
+        out[0] = static_cast<char>( 0xE0 | ( codepoint >> 12 ) );
+        out[1] = static_cast<char>( 0x80 | ( ( codepoint >> 6 ) & 0x3F ) );
+        out[2] = static_cast<char>( 0x80 | ( codepoint & 0x3F ) );
+        return 3;
+    }
+    else if ( codepoint <= 0x10FFFF )
+    {
+        out[0] = static_cast<char>( 0xF0 | ( codepoint >> 18 ) );
+        out[1] = static_cast<char>( 0x80 | ( ( codepoint >> 12 ) & 0x3F ) );
+        out[2] = static_cast<char>( 0x80 | ( ( codepoint >> 6 ) & 0x3F ) );
+        out[3] = static_cast<char>( 0x80 | ( codepoint & 0x3F ) );
+        return 4;
+    }
+
+    return 0;
+}
+
+size_t count( const char * data, size_t size ) noexcept
+{
+    size_t len = 0;
+
+    // Every byte that is not a continuation byte starts a codepoint
+    for ( size_t i = 0; i < size; ++i )
+    {
+        len += ( static_cast<byte_t>( data[i] ) & 0xC0 ) != 0x80;
+    }
+
+    return len;
+}
+
+block_masks classify( const char * data, size_t size, char delim ) noexcept
+{
+    static const classify_fn CLASSIFY = select_classify();
+    return CLASSIFY( data, size, delim );
+}
+
+size_t advance( const char * data, size_t size, size_t bpos, size_t n ) noexcept
+{
+    for ( size_t i = 0; i < n && bpos < size; ++i )
+    {
+        const byte_t byte = static_cast<byte_t>( data[bpos] );
+
+        if ( 0xF0 == ( 0xF8 & byte ) )
+            bpos += 4;
+        else if ( 0xE0 == ( 0xF0 & byte ) )
+            bpos += 3;
+        else if ( 0xC0 == ( 0xE0 & byte ) )
+            bpos += 2;
+        else
+            bpos += 1;
+    }
+
+    return bpos < size ? bpos : size;
+}
+
+size_t find( const char * data, size_t size, const char * needle, size_t nsize ) noexcept
+{
+    return find( data, size, needle, nsize, probe( needle, nsize ) );
+}
+
+size_t find( const char * data, size_t size, const char * needle, size_t nsize,
+             size_t probe ) noexcept
+{
+    static const find_fn FIND = select_find();
+
+    if ( nsize == 0 )
+        return 0;
+
+    // A single byte: memchr() is already vectorized
+    if ( nsize == 1 )
+    {
+        const void * p = size == 0 ? nullptr : std::memchr( data, needle[0], size );
+        return p == nullptr ? npos : static_cast<size_t>( static_cast<const char *>( p ) - data );
+    }
+
+    return FIND( data, size, needle, nsize, probe );
+}
+
+size_t rfind( const char * data, size_t size, const char * needle, size_t nsize ) noexcept
+{
+    if ( nsize > size )
+        return npos;
+
+    if ( nsize == 0 )
+        return size;
+
+    // The last byte of the needle is checked first, from the end
+    const char LAST = needle[nsize - 1];
+
+    for ( size_t i = size; i >= nsize; --i )
+    {
+        if ( data[i - 1] == LAST && std::memcmp( data + i - nsize, needle, nsize - 1 ) == 0 )
+            return i - nsize;
+    }
+
+    return npos;
+}
+
+size_t probe( const char * needle, size_t nsize ) noexcept
+{
+    // A byte equal to the first one filters nothing
+    // ("aaab": the last byte, "abaa": the second one)
+    size_t i = nsize == 0 ? 0 : nsize - 1;
+
+    while ( i > 1 && needle[i] == needle[0] )
+        --i;
+
+    return i;
+}
+
+size_t hash( const char * data, size_t size ) noexcept
+{
+    return static_cast<size_t>( wyhash( reinterpret_cast<const byte_t *>( data ), size ) );
+}
+
+
+size_t units_u16( const char * data, size_t size ) noexcept
+{
+    // One unit per codepoint, and one more for the 4-byte codepoints
+    const byte_t * const P = reinterpret_cast<const byte_t *>( data );
+    size_t n = 0;
+
+    for ( size_t i = 0; i < size; ++i )
+        n += size_t( ( P[i] & 0xC0 ) != 0x80 ) + size_t( P[i] >= 0xF0 );
+
+    return n;
+}
+
+size_t decode_u32( const char * data, size_t size, char32_t * out ) noexcept
+{
+    static const decode_u32_fn DECODE = select_decode_u32();
+    return DECODE( data, size, out );
+}
+
+size_t decode_u16( const char * data, size_t size, char16_t * out ) noexcept
+{
+    static const decode_u16_fn DECODE = select_decode_u16();
+    return DECODE( data, size, out );
+}
+
+size_t size_u32( const char32_t * in, size_t n ) noexcept
+{
+    size_t size = 0;
+
+    for ( size_t i = 0; i < n; ++i )
+    {
+        const char32_t C = in[i];
+
+        if ( C < 0x80 )
+            size += 1;
+        else if ( C < 0x800 )
+            size += 2;
+        else if ( C < 0x10000 && ( C < 0xD800 || C > 0xDFFF ) )
+            size += 3;
+        else if ( C >= 0x10000 && C <= 0x10FFFF )
+            size += 4;
+        else
+            return npos;
+    }
+
+    return size;
+}
+
+size_t size_u16( const char16_t * in, size_t n, size_t& length ) noexcept
+{
+    size_t size = 0;
+    length = 0;
+
+    for ( size_t i = 0; i < n; ++i )
+    {
+        const char16_t C = in[i];
+
+        if ( C < 0x80 )
+            size += 1;
+        else if ( C < 0x800 )
+            size += 2;
+        else if ( C < 0xD800 || C > 0xDFFF )
+            size += 3;
+        else if ( C <= 0xDBFF && i + 1 < n && in[i + 1] >= 0xDC00 && in[i + 1] <= 0xDFFF )
+        {
+            // Surrogate pair
+            size += 4;
+            i += 1;
+        }
+        else
+            return npos;
+
+        length += 1;
+    }
+
+    return size;
+}
+
+size_t encode_u32( const char32_t * in, size_t n, char * out ) noexcept
+{
+    static const encode_u32_fn ENCODE = select_encode_u32();
+    return ENCODE( in, n, out );
+}
+
+size_t encode_u16( const char16_t * in, size_t n, char * out ) noexcept
+{
+    static const encode_u16_fn ENCODE = select_encode_u16();
+    return ENCODE( in, n, out );
+}
+
+}
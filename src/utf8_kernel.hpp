@@ -0,0 +1,335 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#ifndef UTF8_KERNEL_HPP_INCLUDED
+#define UTF8_KERNEL_HPP_INCLUDED
+
+/**
+*   @file utf8_kernel.hpp
+*   @brief Low-level routines working on raw UTF-8 buffers
+*
+*   These functions are used internally by the UTF-8 string library.
+*   They work in place on a byte buffer and never allocate.
+*   The best implementation (AVX2, SSE4.2/SSE2 or scalar, depending
+*   on the routine) is selected at runtime according to the CPU.
+*/
+
+#include "utf8_error.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utf8_kernel
+{
+
+/**
+*   @var npos
+*   Value returned by the functions of the kernel when the buffer is invalid
+*/
+constexpr size_t npos = static_cast<size_t>( -1 );
+
+/**
+*   @fn bool validate(const char * data, size_t size) noexcept
+*
+*   Check if a buffer is a valid UTF-8 sequence
+*
+*   @param data The buffer to check
+*   @param size The size of the buffer (in bytes)
+*   @return TRUE if the buffer is valid, FALSE otherwise
+*/
+bool validate( const char * data, size_t size ) noexcept;
+
+/**
+*   @fn size_t length(const char * data, size_t size) noexcept
+*
+*   Check a buffer and compute its length in the same pass
+*
+*   @param data The buffer to check
+*   @param size The size of the buffer (in bytes)
+*   @return The number of codepoints in the buffer if it is valid,
+*           *npos* otherwise
+*/
+size_t length( const char * data, size_t size ) noexcept;
+
+/**
+*   @struct invalid_sequence
+*   @brief The first invalid sequence of a buffer
+*/
+struct invalid_sequence
+{
+    /// Position of the sequence (in bytes), *npos* if the buffer is valid
+    size_t bpos;
+    /// Size of the maximal subpart of the sequence (in bytes)
+    size_t bsize;
+    /// Number of codepoints before the sequence
+    size_t length;
+    /// Kind of error
+    UTF8error kind;
+};
+
+/**
+*   @fn invalid_sequence find_invalid(const char * data, size_t size) noexcept
+*
+*   Find the first invalid sequence of a buffer.
+*   This is slower than length(), use it once a buffer is known to be invalid.
+*
+*   @param data The buffer to check
+*   @param size The size of the buffer (in bytes)
+*   @return The first invalid sequence. Its maximal subpart is the longest
+*           prefix of a valid sequence, or the first byte if there is none.
+*/
+invalid_sequence find_invalid( const char * data, size_t size ) noexcept;
+
+/**
+*   @fn size_t encode(const char32_t codepoint, char * out) noexcept
+*
+*   Encode a codepoint in UTF-8
+*
+*   @param codepoint The codepoint to encode
+*   @param out The buffer that receives the bytes (at least 4 bytes)
+*   @return The number of bytes written, 0 if the codepoint is a surrogate
+*           or is greater than U+10FFFF (nothing is written)
+*/
+size_t encode( const char32_t codepoint, char * out ) noexcept;
+
+/**
+*   @fn size_t count(const char * data, size_t size) noexcept
+*
+*   Count the codepoints of a valid buffer
+*
+*   @param data The buffer (valid UTF-8 sequence)
+*   @param size The size of the buffer (in bytes)
+*   @return The number of codepoints
+*/
+size_t count( const char * data, size_t size ) noexcept;
+
+/**
+*   @struct block_masks
+*   @brief Classification of the bytes of a block (64 bytes at most)
+*/
+struct block_masks
+{
+    /// Bit i is set if the byte i is the delimiter
+    std::uint64_t delims;
+    /// Bit i is set if the byte i starts a codepoint (it is not a continuation byte)
+    std::uint64_t starts;
+};
+
+/**
+*   @fn block_masks classify(const char * data, size_t size, char delim) noexcept
+*
+*   Find the delimiters and the first bytes of the codepoints of a block
+*
+*   @param data The block
+*   @param size The size of the block (in bytes), 64 at most
+*   @param delim The delimiter
+*   @return The masks of the block, the bits after *size* are not set
+*/
+block_masks classify( const char * data, size_t size, char delim ) noexcept;
+
+/**
+*   @fn size_t popcount(std::uint64_t mask) noexcept
+*
+*   Count the bits set in a mask, without the popcnt instruction
+*   (it is not in the baseline x86-64)
+*
+*   @param mask The mask
+*   @return The number of bits set
+*/
+inline size_t popcount( std::uint64_t mask ) noexcept
+{
+    mask = mask - ( ( mask >> 1 ) & 0x5555555555555555ULL );
+    mask = ( mask & 0x3333333333333333ULL ) + ( ( mask >> 2 ) & 0x3333333333333333ULL );
+    mask = ( mask + ( mask >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<size_t>( ( mask * 0x0101010101010101ULL ) >> 56 );
+}
+
+/**
+*   @fn size_t ctz(std::uint64_t mask) noexcept
+*
+*   Find the lowest bit set in a mask
+*
+*   @param mask The mask, it must not be 0
+*   @return The position of the lowest bit set
+*/
+inline size_t ctz( std::uint64_t mask ) noexcept
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return static_cast<size_t>( __builtin_ctzll( mask ) );
+#else
+    // The bits below the lowest bit set
+    return popcount( ( mask & ( ~mask + 1U ) ) - 1U );
+#endif
+}
+
+/**
+*   @fn size_t advance(const char * data, size_t size, size_t bpos, size_t n) noexcept
+*
+*   Move forward n codepoints in a valid buffer
+*
+*   @param data The buffer (valid UTF-8 sequence)
+*   @param size The size of the buffer (in bytes)
+*   @param bpos The byte position of a codepoint in the buffer
+*   @param n The number of codepoints to skip
+*   @return The byte position of the codepoint,
+*           or *size* if the end of the buffer is reached
+*/
+size_t advance( const char * data, size_t size, size_t bpos, size_t n ) noexcept;
+
+/**
+*   @fn size_t find(const char * data, size_t size, const char * needle, size_t nsize) noexcept
+*
+*   Search for the first occurrence of a byte sequence in a buffer.
+*
+*   UTF-8 is self-synchronizing, so if both buffers are valid UTF-8
+*   sequences, a byte match is always a codepoint match.
+*
+*   @param data The buffer
+*   @param size The size of the buffer (in bytes)
+*   @param needle The sequence to look for
+*   @param nsize The size of the sequence (in bytes)
+*   @return The byte position of the sequence in the buffer, *npos* if it was not found
+*/
+size_t find( const char * data, size_t size, const char * needle, size_t nsize ) noexcept;
+/**
+*   @fn size_t find(const char * data, size_t size, const char * needle, size_t nsize, size_t probe) noexcept
+*
+*   Same as find(), the offset of the second byte that is compared
+*   before a full comparison is given.
+*
+*   @param data The buffer
+*   @param size The size of the buffer (in bytes)
+*   @param needle The sequence to look for
+*   @param nsize The size of the sequence (in bytes)
+*   @param probe The offset of the second byte, the value returned by probe()
+*   @return The byte position of the sequence in the buffer, *npos* if it was not found
+*/
+size_t find( const char * data, size_t size, const char * needle, size_t nsize,
+             size_t probe ) noexcept;
+/**
+*   @fn size_t rfind(const char * data, size_t size, const char * needle, size_t nsize) noexcept
+*
+*   Search for the last occurrence of a byte sequence in a buffer.
+*
+*   @param data The buffer
+*   @param size The size of the buffer (in bytes)
+*   @param needle The sequence to look for
+*   @param nsize The size of the sequence (in bytes)
+*   @return The byte position of the sequence in the buffer, *npos* if it was not found
+*/
+size_t rfind( const char * data, size_t size, const char * needle, size_t nsize ) noexcept;
+/**
+*   @fn size_t probe(const char * needle, size_t nsize) noexcept
+*
+*   Select the byte of a needle that is compared with the first one
+*   by find(). It only depends on the needle, so it can be kept
+*   to search for the same needle again.
+*
+*   @param needle The sequence to look for
+*   @param nsize The size of the sequence (in bytes)
+*   @return The offset of the byte in the needle
+*/
+size_t probe( const char * needle, size_t nsize ) noexcept;
+
+/**
+*   @fn size_t hash(const char * data, size_t size) noexcept
+*
+*   Generate the hash value of a UTF-8 sequence (wyhash, 8 bytes per step)
+*
+*   @param data The buffer
+*   @param size The size of the buffer (in bytes)
+*   @return The hash value
+*/
+size_t hash( const char * data, size_t size ) noexcept;
+
+/**
+*   @fn size_t units_u16(const char * data, size_t size) noexcept
+*
+*   Compute the size of a valid buffer in UTF-16
+*
+*   @param data The buffer (valid UTF-8 sequence)
+*   @param size The size of the buffer (in bytes)
+*   @return The number of UTF-16 code units
+*/
+size_t units_u16( const char * data, size_t size ) noexcept;
+/**
+*   @fn size_t decode_u32(const char * data, size_t size, char32_t * out) noexcept
+*
+*   Convert a valid buffer into UTF-32
+*
+*   @param data The buffer (valid UTF-8 sequence)
+*   @param size The size of the buffer (in bytes)
+*   @param out The output, large enough for every codepoint of the buffer
+*   @return The number of codepoints written
+*/
+size_t decode_u32( const char * data, size_t size, char32_t * out ) noexcept;
+/**
+*   @fn size_t decode_u16(const char * data, size_t size, char16_t * out) noexcept
+*
+*   Convert a valid buffer into UTF-16
+*
+*   @param data The buffer (valid UTF-8 sequence)
+*   @param size The size of the buffer (in bytes)
+*   @param out The output, its size is at least the value returned by units_u16()
+*   @return The number of code units written
+*/
+size_t decode_u16( const char * data, size_t size, char16_t * out ) noexcept;
+
+/**
+*   @fn size_t size_u32(const char32_t * in, size_t n) noexcept
+*
+*   Check a UTF-32 sequence and compute its size in UTF-8
+*
+*   @param in The UTF-32 sequence
+*   @param n The number of codepoints
+*   @return The size of the sequence in UTF-8 (in bytes) if every codepoint is valid,
+*           *npos* otherwise
+*/
+size_t size_u32( const char32_t * in, size_t n ) noexcept;
+/**
+*   @fn size_t size_u16(const char16_t * in, size_t n, size_t& length) noexcept
+*
+*   Check a UTF-16 sequence and compute its size in UTF-8
+*
+*   @param in The UTF-16 sequence
+*   @param n The number of code units
+*   @param length The number of codepoints of the sequence
+*   @return The size of the sequence in UTF-8 (in bytes) if the sequence
+*           is valid (no unpaired surrogate), *npos* otherwise
+*/
+size_t size_u16( const char16_t * in, size_t n, size_t& length ) noexcept;
+/**
+*   @fn size_t encode_u32(const char32_t * in, size_t n, char * out) noexcept
+*
+*   Convert a valid UTF-32 sequence into UTF-8
+*
+*   @param in The UTF-32 sequence, checked by size_u32()
+*   @param n The number of codepoints
+*   @param out The output, its size is the value returned by size_u32()
+*   @return The number of bytes written
+*/
+size_t encode_u32( const char32_t * in, size_t n, char * out ) noexcept;
+/**
+*   @fn size_t encode_u16(const char16_t * in, size_t n, char * out) noexcept
+*
+*   Convert a valid UTF-16 sequence into UTF-8
+*
+*   @param in The UTF-16 sequence, checked by size_u16()
+*   @param n The number of code units
+*   @param out The output, its size is the value returned by size_u16()
+*   @return The number of bytes written
+*/
+size_t encode_u16( const char16_t * in, size_t n, char * out ) noexcept;
+
+}
+
+#endif // UTF8_KERNEL_HPP_INCLUDED
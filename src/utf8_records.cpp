@@ -0,0 +1,187 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#include "utf8_records.hpp"
+#include "utf8_kernel.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+
+namespace
+{
+
+// Size of the blocks read from a stream
+constexpr size_t UTF8_READ_BLOCK = 65536U;
+
+// Bytes classified by the kernel at once
+constexpr size_t UTF8_SPLIT_BLOCK = 64U;
+
+/*
+    Number of bytes between the current position and the end of the stream,
+    0 if it is unknown. The position and the state of the stream are restored
+*/
+size_t stream_size( std::istream& is )
+{
+    const std::istream::pos_type BEGIN = is.tellg();
+
+    if ( BEGIN == std::istream::pos_type( -1 ) )
+        return 0;
+
+    const std::ios::iostate STATE = is.rdstate();
+    size_t size = 0;
+
+    if ( is.seekg( 0, std::ios::end ) )
+    {
+        const std::istream::pos_type END = is.tellg();
+
+        if ( END != std::istream::pos_type( -1 ) && END > BEGIN )
+            size = static_cast<size_t>( END - BEGIN );
+    }
+
+    // The stream may not be seekable, the probe must not stop the reading
+    is.clear( STATE );
+    is.seekg( BEGIN );
+    return size;
+}
+
+}
+
+
+UTF8records::UTF8records( std::string&& buffer, const char delim )
+    : _utf8buffer( std::move( buffer ) ), _utf8records()
+{
+    utf8_split_( delim );
+}
+
+UTF8records::UTF8records( const char * data, const size_t size, const char delim )
+    : _utf8buffer( data, size ), _utf8records()
+{
+    utf8_split_( delim );
+}
+
+UTF8records::UTF8records( std::istream& is, const char delim )
+    : _utf8buffer(), _utf8records()
+{
+    // Read the whole content at once, in place, if the size of the stream is known
+    const size_t SIZE = stream_size( is );
+
+    if ( SIZE > 0 )
+    {
+        _utf8buffer.resize( SIZE );
+        is.read( &_utf8buffer[0], static_cast<std::streamsize>( SIZE ) );
+        _utf8buffer.resize( static_cast<size_t>( is.gcount() ) );
+
+        // Sets eofbit if the stream ends where expected
+        is.peek();
+    }
+
+    // Unknown size, or the stream is longer than it said
+    if ( is )
+    {
+        std::unique_ptr<char[]> block( new char[UTF8_READ_BLOCK] );
+
+        while ( is.read( block.get(), UTF8_READ_BLOCK ) || is.gcount() > 0 )
+        {
+            _utf8buffer.append( block.get(), static_cast<size_t>( is.gcount() ) );
+        }
+    }
+
+    utf8_split_( delim );
+}
+
+
+/*
+    The whole buffer is validated by one call of the kernel. Then one loop
+    classifies it 64 bytes at a time: the delimiters give the bounds
+    of the records, and the first bytes of the codepoints between
+    two delimiters give the length of a record. The kernel is not
+    called for each record, so millions of short records stay cheap.
+    The delimiter is an ASCII character, so it is never a byte
+    of a multi-byte codepoint.
+*/
+void UTF8records::utf8_split_( const char delim )
+{
+    if ( ( 0x80 & static_cast<unsigned char>( delim ) ) != 0 )
+        throw std::invalid_argument( "The delimiter is not an ASCII character\n" );
+
+    const char * const DATA = _utf8buffer.data();
+    const size_t SIZE = _utf8buffer.size();
+
+    if ( !utf8_kernel::validate( DATA, SIZE ) )
+        throw std::invalid_argument( "Invalid UTF-8 string\n" );
+
+    size_t first = 0;
+    size_t length = 0;
+
+    for ( size_t bpos = 0; bpos < SIZE; bpos += UTF8_SPLIT_BLOCK )
+    {
+        const size_t BSIZE = std::min( UTF8_SPLIT_BLOCK, SIZE - bpos );
+        utf8_kernel::block_masks masks = utf8_kernel::classify( DATA + bpos, BSIZE, delim );
+
+        while ( masks.delims != 0 )
+        {
+            const size_t BIT = utf8_kernel::ctz( masks.delims );
+            const std::uint64_t BEFORE = ( std::uint64_t( 1 ) << BIT ) - 1U;
+
+            length += utf8_kernel::popcount( masks.starts & BEFORE );
+            _utf8records.push_back( Record{ first, bpos + BIT - first, length } );
+            first = bpos + BIT + 1;
+            length = 0;
+
+            // The delimiter is a codepoint of no record
+            masks.starts &= ~( BEFORE | ( std::uint64_t( 1 ) << BIT ) );
+            masks.delims &= masks.delims - 1U;
+        }
+
+        length += utf8_kernel::popcount( masks.starts );
+    }
+
+    // If the buffer ends with a delimiter, there is no empty record after it
+    if ( first < SIZE )
+        _utf8records.push_back( Record{ first, SIZE - first, length } );
+}
+
+
+size_t UTF8records::utf8_count() const noexcept
+{
+    return _utf8records.size();
+}
+
+bool UTF8records::utf8_empty() const noexcept
+{
+    return _utf8records.empty();
+}
+
+size_t UTF8records::utf8_size() const noexcept
+{
+    return _utf8buffer.size();
+}
+
+
+UTF8string_view UTF8records::utf8_at( const size_t index ) const
+{
+    if ( index >= _utf8records.size() )
+        throw std::out_of_range( "index value greater than the number of records" );
+
+    return ( *this )[index];
+}
+
+UTF8string_view UTF8records::operator []( const size_t index ) const noexcept
+{
+    const Record& R = _utf8records[index];
+    return UTF8string_view( _utf8buffer.data() + R.bpos, R.size, R.length );
+}
@@ -0,0 +1,125 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#ifndef UTF8_RECORDS_HPP_INCLUDED
+#define UTF8_RECORDS_HPP_INCLUDED
+
+/**
+*   @file utf8_records.hpp
+*   @brief This is a UTF-8 string library header
+*/
+
+#include "utf8_string.hpp"
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+/**
+*   @class UTF8records final
+*   @brief Table of UTF-8 records loaded from one buffer
+*
+*   This class loads a sequence of records separated by a delimiter
+*   (a new line by default). The content is kept in one buffer, it is
+*   checked once, then the position and the length of every record are
+*   computed in one scan of the buffer. A record is a view into the buffer,
+*   so loading many records only needs a few allocations.
+*/
+class UTF8records final
+{
+    struct Record
+    {
+        size_t bpos;
+        size_t size;
+        size_t length;
+    };
+
+    std::string _utf8buffer = {};
+    std::vector<Record> _utf8records = {};
+
+    void utf8_split_( const char delim );
+
+public:
+
+    /**
+    *   @fn UTF8records() = default
+    *   Build an empty table
+    */
+    UTF8records() = default;
+    /**
+    *   @fn explicit UTF8records(std::string&& buffer, const char delim = '\n')
+    *
+    *   Take the buffer and split it into records, nothing is copied.
+    *   If the buffer ends with a delimiter, there is no empty record after it.
+    *
+    *   @param buffer The content
+    *   @param delim The delimiter of the records, an ASCII character
+    *   @exception std::invalid_argument If the content is not valid,
+    *              or if the delimiter is not an ASCII character
+    */
+    explicit UTF8records( std::string&& buffer, const char delim = '\n' );
+    /**
+    *   @fn UTF8records(const char * data, const size_t size, const char delim = '\n')
+    *   @param data The content, it is copied
+    *   @param size The size of the content (in bytes)
+    *   @param delim The delimiter of the records, an ASCII character
+    *   @exception std::invalid_argument If the content is not valid,
+    *              or if the delimiter is not an ASCII character
+    */
+    UTF8records( const char * data, const size_t size, const char delim = '\n' );
+    /**
+    *   @fn explicit UTF8records(std::istream& is, const char delim = '\n')
+    *   Read the stream until the end, and split its content into records
+    *   @param is The input stream
+    *   @param delim The delimiter of the records, an ASCII character
+    *   @exception std::invalid_argument If the content is not valid,
+    *              or if the delimiter is not an ASCII character
+    */
+    explicit UTF8records( std::istream& is, const char delim = '\n' );
+
+    /**
+    *   @fn size_t utf8_count() const noexcept
+    *   @return The number of records
+    */
+    size_t utf8_count() const noexcept;
+    /**
+    *   @fn bool utf8_empty() const noexcept
+    *   @return TRUE if there is no record, FALSE otherwise
+    */
+    bool utf8_empty() const noexcept;
+    /**
+    *   @fn size_t utf8_size() const noexcept
+    *   @return The memory size (in bytes) of the whole content
+    */
+    size_t utf8_size() const noexcept;
+
+    /**
+    *   @fn UTF8string_view utf8_at(const size_t index) const
+    *   @param index The index of the record
+    *   @return A view of the record, without the delimiter
+    *   @exception std::out_of_range If the index is greater than
+    *              or equal to the number of records
+    */
+    UTF8string_view utf8_at( const size_t index ) const;
+    /**
+    *   @fn UTF8string_view operator [](const size_t index) const noexcept
+    *   @param index The index of the record
+    *   @return A view of the record, without the delimiter
+    *   @note If the index is out of range, calling this functions
+    *         causes undefined behaviour
+    */
+    UTF8string_view operator []( const size_t index ) const noexcept;
+
+    ~UTF8records() = default;
+};
+
+#endif // UTF8_RECORDS_HPP_INCLUDED
@@ -0,0 +1,88 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#include "utf8_searcher.hpp"
+#include "utf8_kernel.hpp"
+
+
+UTF8searcher::UTF8searcher( const UTF8string& pattern )
+    : _utf8pattern( pattern ),
+      _utf8probe( utf8_kernel::probe( pattern.utf8_str(), pattern.utf8_size() ) ) {}
+
+UTF8searcher::UTF8searcher( UTF8string&& pattern ) noexcept
+    : _utf8pattern( std::move( pattern ) ),
+      _utf8probe( utf8_kernel::probe( _utf8pattern.utf8_str(), _utf8pattern.utf8_size() ) ) {}
+
+
+// Search from the byte position bpos, which is the codepoint position pos
+size_t UTF8searcher::utf8_find_( const char * data, const size_t size, const size_t bpos,
+                                 const size_t pos, const bool ascii ) const noexcept
+{
+    const size_t FOUND = utf8_kernel::find( data + bpos, size - bpos, _utf8pattern.utf8_str(),
+                                            _utf8pattern.utf8_size(), _utf8probe );
+
+    if ( FOUND == utf8_kernel::npos )
+        return npos;
+
+    return pos + ( ascii ? FOUND : utf8_kernel::count( data + bpos, FOUND ) );
+}
+
+size_t UTF8searcher::utf8_find( const UTF8string& str, size_t pos ) const noexcept
+{
+    const size_t U8LEN = _utf8pattern.utf8_length();
+
+    if ( U8LEN == 0 || pos > str._utf8length || U8LEN > str._utf8length - pos )
+        return npos;
+
+    return utf8_find_( str.utf8_str(), str.utf8_size(), str.utf8_bpos_at_( pos ), pos, str.utf8_is_ascii() );
+}
+
+size_t UTF8searcher::utf8_find( const UTF8string_view& str, size_t pos ) const noexcept
+{
+    const size_t U8LEN = _utf8pattern.utf8_length();
+
+    if ( U8LEN == 0 || pos > str.utf8_length() || U8LEN > str.utf8_length() - pos )
+        return npos;
+
+    const bool ASCII  = str.utf8_is_ascii();
+    const size_t BPOS = ASCII ? pos : utf8_kernel::advance( str.utf8_data(), str.utf8_size(), 0U, pos );
+    return utf8_find_( str.utf8_data(), str.utf8_size(), BPOS, pos, ASCII );
+}
+
+
+std::pair<UTF8iterator, UTF8iterator>
+UTF8searcher::operator ()( const UTF8iterator& first, const UTF8iterator& last ) const noexcept
+{
+    if ( _utf8pattern.utf8_empty() )
+        return std::make_pair( first, first );
+
+    // Only the bytes of [first, last[ are searched
+    const size_t BSIZE = last._bpos - first._bpos;
+    const size_t FOUND = utf8_kernel::find( first._data + first._bpos, BSIZE, _utf8pattern.utf8_str(),
+                                            _utf8pattern.utf8_size(), _utf8probe );
+
+    if ( FOUND == utf8_kernel::npos )
+        return std::make_pair( last, last );
+
+    const size_t BPOS  = first._bpos + FOUND;
+    const size_t INDEX = first._index + utf8_kernel::count( first._data + first._bpos, FOUND );
+
+    return std::make_pair( UTF8iterator( first._data, first._size, BPOS, INDEX ),
+                           UTF8iterator( first._data, first._size, BPOS + _utf8pattern.utf8_size(),
+                                         INDEX + _utf8pattern.utf8_length() ) );
+}
+
+
+const UTF8string& UTF8searcher::utf8_pattern() const noexcept
+{
+    return _utf8pattern;
+}
@@ -0,0 +1,108 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#ifndef UTF8_SEARCHER_HPP_INCLUDED
+#define UTF8_SEARCHER_HPP_INCLUDED
+
+/**
+*   @file utf8_searcher.hpp
+*   @brief This is a UTF-8 string library header
+*/
+
+#include "utf8_string.hpp"
+
+#include <utility>
+
+/**
+*   @class UTF8searcher final
+*   @brief Precompiled search of a pattern
+*
+*   This class keeps a pattern and everything that is computed
+*   from it to search it, so the same pattern can be searched
+*   in many strings without preprocessing it every time.
+*
+*   It can be used as a searcher of *std::search* (C++17).
+*/
+class UTF8searcher final
+{
+    UTF8string _utf8pattern = {};
+    size_t _utf8probe = 0U;
+
+    size_t utf8_find_( const char * data, const size_t size, const size_t bpos,
+                       const size_t pos, const bool ascii ) const noexcept;
+
+public:
+
+    /**
+    *   @var npos
+    *   @brief Same as UTF8string::npos
+    */
+    constexpr static size_t npos = UTF8string::npos;
+
+    /**
+    *   @fn explicit UTF8searcher(const UTF8string& pattern)
+    *   @param pattern The utf-8 string to look for
+    */
+    explicit UTF8searcher( const UTF8string& pattern );
+    /**
+    *   @fn explicit UTF8searcher(UTF8string&& pattern) noexcept
+    *   @param pattern The utf-8 string to look for
+    */
+    explicit UTF8searcher( UTF8string&& pattern ) noexcept;
+
+    /**
+    *   @fn size_t utf8_find(const UTF8string& str, size_t pos = 0) const noexcept
+    *
+    *   Search for the first occurrence of the pattern in str,
+    *   from the position pos.
+    *
+    *   @param str The string to search in
+    *   @param pos The position to start the search
+    *   @return The same position as ```str.utf8_find(pattern, pos)```
+    */
+    size_t utf8_find( const UTF8string& str, size_t pos = 0 ) const noexcept;
+    /**
+    *   @fn size_t utf8_find(const UTF8string_view& str, size_t pos = 0) const noexcept
+    *
+    *   Search for the first occurrence of the pattern in a view,
+    *   from the position pos.
+    *
+    *   @param str The view to search in
+    *   @param pos The position to start the search
+    *   @return The same position as ```str.utf8_find(pattern, pos)```
+    */
+    size_t utf8_find( const UTF8string_view& str, size_t pos = 0 ) const noexcept;
+
+    /**
+    *   @fn std::pair<UTF8iterator, UTF8iterator> operator ()(const UTF8iterator& first, const UTF8iterator& last) const noexcept
+    *
+    *   Search for the first occurrence of the pattern in [first, last[
+    *
+    *   @param first The beginning of the range
+    *   @param last The end of the range
+    *   @return The range of the occurrence, ```(last, last)``` if it was not found.
+    *           ```(first, first)``` if the pattern is empty.
+    *   @note The iterators must point to the same string
+    */
+    std::pair<UTF8iterator, UTF8iterator> operator ()( const UTF8iterator& first,
+                                                       const UTF8iterator& last ) const noexcept;
+
+    /**
+    *   @fn const UTF8string& utf8_pattern() const noexcept
+    *   @return The pattern
+    */
+    const UTF8string& utf8_pattern() const noexcept;
+
+    ~UTF8searcher() = default;
+};
+
+#endif // UTF8_SEARCHER_HPP_INCLUDED
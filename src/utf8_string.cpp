@@ -11,278 +11,315 @@
 */
 
 #include "utf8_string.hpp"
+#include "utf8_kernel.hpp"
 
-#include <unordered_map>
+#include <algorithm>
 #include <utility>
+#include <cstring>
+#include <cstdint>
+#include <exception>
+#include <mutex>
 
 
 namespace
 {
 
+// One sample every 256 codepoints: 8 bytes per 256 bytes at worst (~3%)
+constexpr size_t UTF8_INDEX_STEP = 256U;
+// Below this length, walking from the beginning is cheap enough
+constexpr size_t UTF8_INDEX_MIN_LENGTH = 1024U;
+// The indexes are built under one of these locks, chosen from the address of the string
+constexpr size_t UTF8_INDEX_LOCKS = 64U;
+
+std::mutex& index_lock( const void * str ) noexcept
+{
+    static std::mutex locks[UTF8_INDEX_LOCKS];
+    return locks[( reinterpret_cast<uintptr_t>( str ) / 64U ) % UTF8_INDEX_LOCKS];
+}
+
 constexpr size_t min( size_t a, size_t b )
 {
     return a < b ? a : b;
 }
 
-inline std::basic_string<unsigned char> toUstring( const std::string& str )
+// Take the buffer of src, it can only be done if dst is a std::string
+void take( std::string& dst, std::string&& src ) noexcept
 {
-    return std::basic_string<unsigned char>( str.begin(), str.end() );
+    dst = std::move( src );
 }
 
-// Used in utf8_find
-void preprocess( const UTF8string& str,
-                 std::unordered_map<UTF8string::u8char, size_t>& u8map ) noexcept
+template <typename String>
+void take( String& dst, std::string&& src )
 {
-    const size_t U8LEN = str.utf8_length();
+    dst.assign( src.data(), src.size() );
+}
 
-    // Preprocessing
-    if ( U8LEN > 1 )
-    {
-        for ( size_t i = U8LEN - 2U; ; --i )
-        {
-            const UTF8string::u8char& s = str[i];
+// Each maximal invalid subpart becomes U+FFFD, the length of the result is returned
+template <typename String>
+size_t repair( String& out, const char * data, const size_t size )
+{
+    const char REPLACEMENT[] = "\xEF\xBF\xBD";
+    size_t bpos = 0;
+    size_t len = 0;
 
-            if ( u8map.find( s ) == u8map.end() )
-                u8map[s] = U8LEN - 1 - i;
+    out.reserve( size );
+
+    while ( bpos < size )
+    {
+        const utf8_kernel::invalid_sequence E = utf8_kernel::find_invalid( data + bpos, size - bpos );
 
-            if ( i == 0 )
-                break;
+        if ( E.bpos == utf8_kernel::npos )
+        {
+            out.append( data + bpos, size - bpos );
+            return len + E.length;
         }
+
+        out.append( data + bpos, E.bpos );
+        out.append( REPLACEMENT, 3 );
+        len  += E.length + 1;
+        bpos += E.bpos + E.bsize;
     }
+
+    return len;
 }
 
 }
 
 
-UTF8string::UTF8string( const char * str )
-    : UTF8string( std::string( str ) ) {}
+// Trusted content: data is a valid sequence of length codepoints
+template <typename Allocator>
+UTF8basic_string<Allocator>::UTF8basic_string( const char * data, const size_t size,
+                                               const size_t length, const Allocator& alloc )
+    : _utf8string( data, size, alloc ), _utf8length( length ), _utf8index( index_allocator( alloc ) ) {}
 
 
-UTF8string::UTF8string( const std::string& str )
-    : _utf8string( str )
-{
-    if ( !utf8_is_valid_() )
-        throw std::invalid_argument( "Invalid UTF-8 string\n" );
+template <typename Allocator>
+UTF8basic_string<Allocator>::UTF8basic_string( const Allocator& alloc ) noexcept
+    : _utf8string( alloc ), _utf8length( 0U ), _utf8index( index_allocator( alloc ) ) {}
+
+
+template <typename Allocator>
+UTF8basic_string<Allocator>::UTF8basic_string( const char * str, const Allocator& alloc )
+    : _utf8string( str, alloc ), _utf8length( utf8_validate_( _utf8string.data(), _utf8string.size() ) ),
+      _utf8index( index_allocator( alloc ) ) {}
 
-    _utf8length = utf8_length_();
+
+template <typename Allocator>
+UTF8basic_string<Allocator>::UTF8basic_string( const std::string& str, const Allocator& alloc )
+    : _utf8string( str.data(), str.size(), alloc ), _utf8length( utf8_validate_( str.data(), str.size() ) ),
+      _utf8index( index_allocator( alloc ) ) {}
+
+// str is checked before its buffer is taken
+template <typename Allocator>
+UTF8basic_string<Allocator>::UTF8basic_string( std::string&& str, const Allocator& alloc )
+    : _utf8string( alloc ), _utf8length( utf8_validate_( str.data(), str.size() ) ),
+      _utf8index( index_allocator( alloc ) )
+{
+    take( _utf8string, std::move( str ) );
 }
 
 
-UTF8string::UTF8string( const UTF8string& u8str ) noexcept
-    : _utf8string( u8str._utf8string ), _utf8length( u8str._utf8length ) {}
+template <typename Allocator>
+UTF8basic_string<Allocator>::UTF8basic_string( const UTF8basic_string& u8str ) noexcept
+    : _utf8string( u8str._utf8string ), _utf8length( u8str._utf8length ),
+      _utf8index( index_allocator( _utf8string.get_allocator() ) ),
+      _utf8hash( u8str._utf8hash.load( std::memory_order_relaxed ) ) {}
 
-UTF8string::UTF8string( const UTF8string& u8str, size_t pos, size_t len ) noexcept
-    : UTF8string( u8str.utf8_substr( pos, len ) ) {}
+template <typename Allocator>
+UTF8basic_string<Allocator>::UTF8basic_string( const UTF8basic_string& u8str, size_t pos, size_t len ) noexcept
+    : UTF8basic_string( u8str.utf8_substr( pos, len ) ) {}
 
-UTF8string::UTF8string( UTF8string&& u8str ) noexcept
-    : _utf8string( u8str._utf8string ), _utf8length( u8str._utf8length )
+template <typename Allocator>
+UTF8basic_string<Allocator>::UTF8basic_string( UTF8basic_string&& u8str ) noexcept
+    : _utf8string( std::move( u8str._utf8string ) ), _utf8length( u8str._utf8length ),
+      _utf8index( std::move( u8str._utf8index ) ),
+      _utf8indexed( u8str._utf8indexed.load( std::memory_order_relaxed ) ),
+      _utf8hash( u8str._utf8hash.load( std::memory_order_relaxed ) )
 {
     u8str.utf8_clear();
-    u8str._utf8string.shrink_to_fit();
 }
 
-UTF8string& UTF8string::operator =( const char * str )
+template <typename Allocator>
+UTF8basic_string<Allocator>::UTF8basic_string( const UTF8string_view& u8view, const Allocator& alloc )
+    : UTF8basic_string( u8view.utf8_data(), u8view.utf8_size(), u8view.utf8_length(), alloc ) {}
+
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::operator =( const char * str )
 {
     return utf8_assign( str );
 }
 
 
-UTF8string& UTF8string::operator =( const std::string& str )
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::operator =( const std::string& str )
 {
     return utf8_assign( str );
 }
 
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::operator =( std::string&& str )
+{
+    return utf8_assign( std::move( str ) );
+}
 
-UTF8string& UTF8string::operator =( const UTF8string& u8str ) noexcept
+
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::operator =( const UTF8basic_string& u8str ) noexcept
 {
     _utf8string = u8str._utf8string;
     _utf8length = u8str._utf8length;
+    utf8_invalidate_();
+    _utf8hash.store( u8str._utf8hash.load( std::memory_order_relaxed ), std::memory_order_relaxed );
     return *this;
 }
 
-UTF8string& UTF8string::operator =( UTF8string&& u8str ) noexcept
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::operator =( UTF8basic_string&& u8str ) noexcept( UTF8_MOVE_NOEXCEPT )
 {
     return utf8_assign( std::move( u8str ) );
 }
 
-const UTF8string& UTF8string::operator +=( const std::string& str )
+/*
+    A valid utf-8 string always ends with a complete codepoint,
+    so only the appended bytes need to be checked and counted
+*/
+template <typename Allocator>
+const UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::operator +=( const std::string& str )
 {
-    const UTF8string::u8string BACKUP = _utf8string;
-    _utf8string += str;
+    const size_t LEN = utf8_validate_( str.data(), str.size() );
+    _utf8string.append( str.data(), str.size() );
+    _utf8length += LEN;
+    utf8_invalidate_cache_();
+    return *this;
+}
 
-    if ( !utf8_is_valid_() )
-    {
-        _utf8string = BACKUP;
-        throw std::invalid_argument( "Invalid UTF-8 string\n" );
-    }
 
-    _utf8length = utf8_length_();
+template <typename Allocator>
+const UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::operator +=( const UTF8basic_string& u8str )
+{
+    _utf8string += u8str._utf8string;
+    _utf8length += u8str._utf8length;
+    utf8_invalidate_cache_();
     return *this;
 }
 
 
-const UTF8string& UTF8string::operator +=( const UTF8string& u8str )
+template <typename Allocator>
+const UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::operator +=( const char * str )
 {
-    _utf8string  += u8str._utf8string;
-    _utf8length = utf8_length_();
+    const size_t SZ  = std::strlen( str );
+    const size_t LEN = utf8_validate_( str, SZ );
+    _utf8string.append( str, SZ );
+    _utf8length += LEN;
+    utf8_invalidate_cache_();
     return *this;
 }
 
 
-const UTF8string& UTF8string::operator +=( const char * str )
+// Check a buffer and get its length (in number of codepoints)
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_validate_( const char * data, const size_t size )
 {
-    UTF8string::u8string BACKUP = _utf8string;
-    _utf8string += std::move( UTF8string::u8string( str ) );
+    const size_t LEN = utf8_kernel::length( data, size );
 
-    if ( !utf8_is_valid_() )
-    {
-        _utf8string = BACKUP;
+    if ( LEN == utf8_kernel::npos )
         throw std::invalid_argument( "Invalid UTF-8 string\n" );
-    }
 
-    _utf8length = utf8_length_();
-    return *this;
+    return LEN;
 }
 
-
-bool UTF8string::utf8_is_valid_() const noexcept
+// The error is only located once the content is known to be invalid
+template <typename Allocator>
+UTF8basic_result<Allocator> UTF8basic_string<Allocator>::try_from( const char * data, const size_t size,
+                                                                   const Allocator& alloc )
 {
-    const std::basic_string<unsigned char> U8STRING = toUstring( _utf8string );
-    auto it = U8STRING.begin();
-    const auto ITEND = U8STRING.cend();
+    const size_t LEN = utf8_kernel::length( data, size );
 
-    while ( it < ITEND )
+    if ( LEN == utf8_kernel::npos )
     {
-        if ( ( 0xF8 & *it ) == 0xF0 && *it <= 0xF4 )
-        {
-            // The UTF-8 codepoint begin with 0b11110xxx -> 4-byte codepoint
-            // If the iterator reach the end of the string before the
-            // end of the 4-byte codepoint -> invalid string
-            if ( ( it + 1 ) == ITEND || ( it + 2 ) == ITEND || ( it + 3 ) == ITEND )
-                return false;
-
-            // Each of the following bytes is a value
-            // between 0x80 and 0xBF
-            if ( ( ( 0xC0 & *( it + 1 ) ) != 0x80 ) || ( ( 0xC0 & *( it + 2 ) ) != 0x80 )
-                    || ( ( 0xC0 & *( it + 3 ) ) != 0x80 ) )
-            {
-                return false;
-            }
+        const utf8_kernel::invalid_sequence E = utf8_kernel::find_invalid( data, size );
+        return UTF8basic_result<Allocator>( alloc, E.kind, E.bpos );
+    }
 
-            // If the first byte of the sequence is 0xF0
-            // then the first continuation byte must be between 0x90 and 0xBF
-            // otherwise, if the byte is 0xF4
-            // then the first continuation byte must be between 0x80 and 0x8F
-            if ( *it == 0xF0 )
-            {
-                if ( *( it + 1 ) < 0x90 || *( it + 1 ) > 0xBF )
-                    return false;
-            }
-            else if ( *it == 0xF4 )
-            {
-                if ( *( it + 1 ) < 0x80 || *( it + 1 ) > 0x8F )
-                    return false;
-            }
+    return UTF8basic_result<Allocator>( UTF8basic_string( data, size, LEN, alloc ) );
+}
 
-            it += 4;    // Jump to the next codepoint
-        }
-        else if ( ( 0xF0 & *it ) == 0xE0 )
-        {
-            // The UTF-8 codepoint begin with 0b1110xxxx -> 3-byte codepoint
-            if ( ( it + 1 ) == ITEND || ( it + 2 ) == ITEND )
-                return false;
-
-            // Each of the following bytes starts with
-            // 0b10xxxxxx in a valid string
-            if ( ( ( 0xC0 & *( it + 1 ) ) != 0x80 ) || ( ( 0xC0 & *( it + 2 ) ) != 0x80 ) )
-                return false;
-
-            // If the first byte of the sequence is 0xE0
-            // then the first continuation byte must be between 0xA0 and 0xBF
-            // otherwise, if the byte is 0xF4
-            // then the first continuation byte must be between 0x80 and 0x9F
-            if ( *it == 0xE0 )
-            {
-                if ( *( it + 1 ) < 0xA0 || *( it + 1 ) > 0xBF )
-                    return false;
-            }
-            else if ( *it == 0xED )
-            {
-                if ( *( it + 1 ) > 0x9F )
-                    return false;
-            }
+template <typename Allocator>
+UTF8basic_result<Allocator> UTF8basic_string<Allocator>::try_from( const char * str, const Allocator& alloc )
+{
+    return try_from( str, std::strlen( str ), alloc );
+}
 
-            it += 3;
-        }
-        else if ( ( 0xE0 & *it ) == 0xC0 )
-        {
-            // The UTF-8 codepoint begin with 0b110xxxxx -> 2-byte codepoint
-            if ( ( it + 1 ) == ITEND )
-                return false;
+template <typename Allocator>
+UTF8basic_result<Allocator> UTF8basic_string<Allocator>::try_from( const std::string& str, const Allocator& alloc )
+{
+    return try_from( str.data(), str.size(), alloc );
+}
 
-            // The following byte starts with 0b10xxxxxx in a valid string
-            if ( ( 0xC0 & *( it + 1 ) ) != 0x80 )
-                return false;
+template <typename Allocator>
+UTF8basic_result<Allocator> UTF8basic_string<Allocator>::try_from( std::string&& str, const Allocator& alloc )
+{
+    const size_t LEN = utf8_kernel::length( str.data(), str.size() );
 
-            it += 2;
-        }
-        else if ( ( 0x80 & *it ) == 0x00 )
-        {
-            // The UTF-8 codepoint begin with 0b0xxxxxxx -> 1-byte codepoint
-            it += 1;
-        }
-        else
-        {
-            // Invalid codepoint
-            return false;
-        }
+    if ( LEN == utf8_kernel::npos )
+    {
+        const utf8_kernel::invalid_sequence E = utf8_kernel::find_invalid( str.data(), str.size() );
+        return UTF8basic_result<Allocator>( alloc, E.kind, E.bpos );
     }
 
-    return true;
+    UTF8basic_string u8( alloc );
+    take( u8._utf8string, std::move( str ) );
+    u8._utf8length = LEN;
+    return UTF8basic_result<Allocator>( std::move( u8 ) );
 }
 
-// Compute the length of the utf-8 string (in number of codepoints)
-size_t UTF8string::utf8_length_() const noexcept
+// Valid content is only checked, it is repaired otherwise
+template <typename Allocator>
+UTF8basic_string<Allocator> UTF8basic_string<Allocator>::from_lossy( const char * data, const size_t size,
+                                                                     const Allocator& alloc )
 {
-    auto end_data = _utf8string.end();
-    auto it = _utf8string.begin();
-    size_t len = 0;
+    const size_t LEN = utf8_kernel::length( data, size );
 
-    while ( it != end_data )
-    {
-        byte_t byte = static_cast<byte_t>( *it );
+    if ( LEN != utf8_kernel::npos )
+        return UTF8basic_string( data, size, LEN, alloc );
 
-        if ( 0xf0 == ( 0xf8 & byte ) )
-        {
-            // 4-byte utf8 character
-            // (0b11110xxx 0bxxxxxxxx 0bxxxxxxxx 0bxxxxxxxx)
-            it += 4;
-        }
-        else if ( 0xe0 == ( 0xf0 & byte ) )
-        {
-            // 3-byte utf8 code point (0b110xxxxx 0bxxxxxxxx 0bxxxxxxxx)
-            it += 3;
-        }
-        else if ( 0xc0 == ( 0xe0 & byte ) )
-        {
-            // 2-byte utf8 code point (0b110xxxxx 0bxxxxxxxx)
-            it += 2;
-        }
-        else
-        {
-            // 1-byte utf8 code point (0b0xxxxxxx)
-            it += 1;
-        }
+    UTF8basic_string u8( alloc );
+    u8._utf8length = repair( u8._utf8string, data, size );
+    return u8;
+}
+
+template <typename Allocator>
+UTF8basic_string<Allocator> UTF8basic_string<Allocator>::from_lossy( const char * str, const Allocator& alloc )
+{
+    return from_lossy( str, std::strlen( str ), alloc );
+}
+
+template <typename Allocator>
+UTF8basic_string<Allocator> UTF8basic_string<Allocator>::from_lossy( const std::string& str, const Allocator& alloc )
+{
+    return from_lossy( str.data(), str.size(), alloc );
+}
 
-        // We want the number of characters (utf-8 code point)
-        len += 1;
+template <typename Allocator>
+UTF8basic_string<Allocator> UTF8basic_string<Allocator>::from_lossy( std::string&& str, const Allocator& alloc )
+{
+    const size_t LEN = utf8_kernel::length( str.data(), str.size() );
+    UTF8basic_string u8( alloc );
+
+    if ( LEN != utf8_kernel::npos )
+    {
+        take( u8._utf8string, std::move( str ) );
+        u8._utf8length = LEN;
     }
+    else
+        u8._utf8length = repair( u8._utf8string, str.data(), str.size() );
 
-    return len;
+    return u8;
 }
 
 // Compute the memory size of a codepoint in the string (in byte)
-size_t UTF8string::utf8_codepoint_len_( const size_t j ) const noexcept
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_codepoint_len_( const size_t j ) const noexcept
 {
     if ( 0xf0 == ( 0xf8 & _utf8string[j] ) )
     {
@@ -301,71 +338,81 @@ size_t UTF8string::utf8_codepoint_len_( const size_t j ) const noexcept
 }
 
 
-void UTF8string::utf8_clear() noexcept
+template <typename Allocator>
+void UTF8basic_string<Allocator>::utf8_clear() noexcept
 {
     _utf8string.clear();
     _utf8length = 0;
+    utf8_invalidate_();
 }
 
 
-bool UTF8string::utf8_empty() const noexcept
+template <typename Allocator>
+bool UTF8basic_string<Allocator>::utf8_empty() const noexcept
 {
     return _utf8length == 0;
 }
 
 
-UTF8string& UTF8string::utf8_assign( const char * str )
+// The new content is checked before the object is modified
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::utf8_assign( const char * str )
 {
-    const UTF8string::u8string BACKUP = _utf8string;
-    _utf8string = std::string( str );
-
-    if ( !utf8_is_valid_() )
-    {
-        _utf8string = BACKUP;
-        throw std::invalid_argument( "Invalid UTF-8 string\n" );
-    }
-
-    _utf8length = utf8_length_();
+    const size_t SZ  = std::strlen( str );
+    const size_t LEN = utf8_validate_( str, SZ );
+    _utf8string.assign( str, SZ );
+    _utf8length = LEN;
+    utf8_invalidate_();
     return *this;
 }
 
-UTF8string& UTF8string::utf8_assign( const u8string& str )
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::utf8_assign( const std::string& str )
 {
-    const UTF8string::u8string BACKUP = _utf8string;
-    _utf8string = str;
-
-    if ( !utf8_is_valid_() )
-    {
-        _utf8string = BACKUP;
-        throw std::invalid_argument( "Invalid UTF-8 string\n" );
-    }
-
-    _utf8length = utf8_length_();
+    const size_t LEN = utf8_validate_( str.data(), str.size() );
+    _utf8string.assign( str.data(), str.size() );
+    _utf8length = LEN;
+    utf8_invalidate_();
     return *this;
 }
 
-UTF8string& UTF8string::utf8_assign( const u8string& str, size_t pos, size_t count )
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::utf8_assign( std::string&& str )
 {
-    const UTF8string::u8string BACKUP = _utf8string;
-    _utf8string = str.substr( pos, count );
+    const size_t LEN = utf8_validate_( str.data(), str.size() );
+    take( _utf8string, std::move( str ) );
+    _utf8length = LEN;
+    utf8_invalidate_();
+    return *this;
+}
 
-    if ( !utf8_is_valid_() )
-    {
-        _utf8string = BACKUP;
-        throw std::invalid_argument( "Invalid UTF-8 string\n" );
-    }
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::utf8_assign( const std::string& str, size_t pos, size_t count )
+{
+    if ( pos > str.size() )
+        throw std::out_of_range( "utf8_assign - position out of range" );
 
-    _utf8length = utf8_length_();
+    const size_t SZ  = min( count, str.size() - pos );
+    const size_t LEN = utf8_validate_( str.data() + pos, SZ );
+    _utf8string.assign( str.data() + pos, SZ );
+    _utf8length = LEN;
+    utf8_invalidate_();
     return *this;
 }
 
-UTF8string& UTF8string::utf8_assign( UTF8string&& u8str ) noexcept
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::utf8_assign( UTF8basic_string&& u8str ) noexcept( UTF8_MOVE_NOEXCEPT )
 {
-    _utf8string = u8str._utf8string;
-    _utf8length = u8str._utf8length;
-
-    u8str.utf8_clear();
-    u8str._utf8string.shrink_to_fit();
+    if ( this != &u8str )
+    {
+        // The buffer and the index are taken as they are
+        _utf8string = std::move( u8str._utf8string );
+        _utf8length = u8str._utf8length;
+        _utf8index  = std::move( u8str._utf8index );
+        _utf8indexed.store( u8str._utf8indexed.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        _utf8hash.store( u8str._utf8hash.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        u8str.utf8_clear();
+    }
 
     return *this;
 }
@@ -375,27 +422,131 @@ UTF8string& UTF8string::utf8_assign( UTF8string&& u8str ) noexcept
     Get the memory position of a codepoint according
     to its position in the utf-8 string
 */
-size_t UTF8string::utf8_bpos_at_( const size_t cpos ) const noexcept
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_bpos_at_( const size_t cpos ) const noexcept
 {
     size_t bpos = 0;
+    size_t i = 0;
     const size_t U8SIZE = utf8_size();
 
-    for ( size_t i = 0; bpos < U8SIZE && i < cpos; i++ )
+    // One byte per codepoint, no index is needed
+    if ( utf8_is_ascii() )
+        return min( cpos, U8SIZE );
+
+    if ( _utf8length >= UTF8_INDEX_MIN_LENGTH && cpos < _utf8length )
+    {
+        try
+        {
+            utf8_index_();
+            bpos = _utf8index[cpos / UTF8_INDEX_STEP];
+            i = cpos - cpos % UTF8_INDEX_STEP;
+        }
+        catch ( const std::exception& )
+        {
+            // No memory for the index or the lock failed (std::system_error),
+            // walk from the beginning
+        }
+    }
+
+    for ( ; bpos < U8SIZE && i < cpos; i++ )
     {
         bpos += utf8_codepoint_len_( bpos );
     }
     return bpos;
 }
 
+/*
+    Build the index of codepoint positions, or complete it.
+
+    The samples that are still valid are kept by utf8_pop(), operator +=
+    and utf8_erase(), any other modification clears the index.
+*/
+template <typename Allocator>
+void UTF8basic_string<Allocator>::utf8_index_() const
+{
+    if ( _utf8indexed.load( std::memory_order_acquire ) )
+        return;
+
+    // Readers of a shared string may get here at the same time, only one builds the index
+    std::lock_guard<std::mutex> lock( index_lock( this ) );
+
+    if ( _utf8indexed.load( std::memory_order_relaxed ) )
+        return;
+
+    const size_t NSAMPLES = ( _utf8length + UTF8_INDEX_STEP - 1 ) / UTF8_INDEX_STEP;
+    const size_t U8SIZE = utf8_size();
+
+    // Samples of removed codepoints
+    while ( !_utf8index.empty() && _utf8index.back() >= U8SIZE )
+        _utf8index.pop_back();
+
+    if ( _utf8index.size() < NSAMPLES )
+    {
+        _utf8index.reserve( NSAMPLES );
+
+        if ( _utf8index.empty() )
+            _utf8index.push_back( 0U );
+
+        size_t bpos = _utf8index.back();
+
+        while ( _utf8index.size() < NSAMPLES )
+        {
+            for ( size_t i = 0; i < UTF8_INDEX_STEP; ++i )
+            {
+                bpos += utf8_codepoint_len_( bpos );
+            }
+
+            _utf8index.push_back( bpos );
+        }
+    }
+
+    _utf8indexed.store( true, std::memory_order_release );
+}
+
+// Same as utf8_kernel::advance() on the string, in constant time if it is ASCII
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_advance_( const size_t bpos, const size_t n ) const noexcept
+{
+    if ( utf8_is_ascii() )
+        return min( bpos + n, _utf8string.size() );
+
+    return utf8_kernel::advance( _utf8string.data(), _utf8string.size(), bpos, n );
+}
+
+// Same as utf8_kernel::count() on a part of the string
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_count_( const char * data, const size_t size ) const noexcept
+{
+    return utf8_is_ascii() ? size : utf8_kernel::count( data, size );
+}
+
+// The content has been modified, the index and the hash value are no longer valid
+template <typename Allocator>
+void UTF8basic_string<Allocator>::utf8_invalidate_() noexcept
+{
+    _utf8index.clear();
+    utf8_invalidate_cache_();
+}
+
+// The samples are kept, but the index is completed again before it is used
+template <typename Allocator>
+void UTF8basic_string<Allocator>::utf8_invalidate_cache_() noexcept
+{
+    _utf8indexed.store( false, std::memory_order_relaxed );
+    _utf8hash.store( 0U, std::memory_order_relaxed );
+}
 
-UTF8string::u8string UTF8string::utf8_at_( const size_t index ) const noexcept
+
+template <typename Allocator>
+UTF8char UTF8basic_string<Allocator>::utf8_at_( const size_t index ) const noexcept
 {
     size_t bpos = utf8_bpos_at_( index );
-    return _utf8string.substr( bpos, utf8_codepoint_len_( bpos ) );
+    return UTF8char( _utf8string.data() + bpos, utf8_codepoint_len_( bpos ) );
 }
 
 
-UTF8string::u8char UTF8string::utf8_at( const size_t index ) const
+template <typename Allocator>
+UTF8char UTF8basic_string<Allocator>::utf8_at( const size_t index ) const
 {
     if ( index >= _utf8length )
         throw std::out_of_range( "index value greater than the size of the string" );
@@ -404,23 +555,32 @@ UTF8string::u8char UTF8string::utf8_at( const size_t index ) const
 }
 
 
-UTF8string::u8char UTF8string::operator []( const size_t index ) const noexcept
+template <typename Allocator>
+UTF8char UTF8basic_string<Allocator>::operator []( const size_t index ) const noexcept
 {
     return utf8_at_( index );
 }
 
 
-void UTF8string::utf8_pop()
+template <typename Allocator>
+void UTF8basic_string<Allocator>::utf8_pop()
 {
     if ( _utf8length == 0 )
         throw std::length_error( "Cannot remove the last element from an empty string" );
 
-    size_t bpos = utf8_bpos_at_( _utf8length - 1 );
+    // Go back to the first byte of the last codepoint
+    size_t bpos = _utf8string.size() - 1;
+
+    while ( ( 0xc0 & static_cast<byte_t>( _utf8string[bpos] ) ) == 0x80 )
+        bpos -= 1;
+
     _utf8string.erase( bpos );
     _utf8length -= 1;
+    utf8_invalidate_cache_();
 }
 
-UTF8string& UTF8string::utf8_erase( const size_t index, const size_t count )
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::utf8_erase( const size_t index, const size_t count )
 {
     if ( index > _utf8length )
         throw std::out_of_range( "utf8_range - index out of range" );
@@ -431,286 +591,397 @@ UTF8string& UTF8string::utf8_erase( const size_t index, const size_t count )
         return *this;
 
     const size_t BFIRST = utf8_bpos_at_( index );
-    const size_t BLAST  = utf8_bpos_at_( index + COUNT );
-    const size_t N      = _utf8string.size();
-    u8string u8s;
-
-    for ( size_t i = 0U; i < N; ++i )
-    {
-        if ( i < BFIRST || i > BLAST - 1 )
-            u8s += _utf8string[i];
-    }
-
-    _utf8string = u8s;
-    _utf8length = utf8_length_();
+    const size_t BLAST  = utf8_advance_( BFIRST, COUNT );
+    utf8_erase_bytes_( BFIRST, BLAST, COUNT );
     return *this;
 }
 
-UTF8iterator UTF8string::utf8_erase( const UTF8iterator& position )
+// The iterators already know their byte position and their index
+template <typename Allocator>
+UTF8iterator UTF8basic_string<Allocator>::utf8_erase( const UTF8iterator& position )
 {
-    if ( position == utf8_end() )
-        return utf8_end();
-
-    if ( position == utf8_end() - 1 )
-    {
-        utf8_pop();
+    if ( position._bpos >= _utf8string.size() )
         return utf8_end();
-    }
 
-    const size_t d = static_cast<size_t>( position - utf8_begin() );
-    utf8_erase( d, 1U );
-    return utf8_begin() + d;
+    utf8_erase_bytes_( position._bpos, position._bpos + utf8_codepoint_len_( position._bpos ), 1U );
+    return UTF8iterator( _utf8string.data(), _utf8string.size(), position._bpos, position._index );
 }
 
-UTF8iterator UTF8string::utf8_erase( const UTF8iterator& first, const UTF8iterator& last )
+template <typename Allocator>
+UTF8iterator UTF8basic_string<Allocator>::utf8_erase( const UTF8iterator& first, const UTF8iterator& last )
 {
     if ( first == last )
         return utf8_end();
 
-    if ( first == utf8_begin() && last == utf8_end() )
-    {
-        utf8_clear();
-        return utf8_end();
-    }
-
     const UTF8iterator& REAL_FIRST = first < last ? first : last;
     const UTF8iterator& REAL_LAST  = first < last ? last : first;
 
-    const size_t INDEX = static_cast<size_t>( REAL_FIRST - utf8_begin() );
-    const size_t COUNT = static_cast<size_t>( REAL_LAST - REAL_FIRST );
-    utf8_erase( INDEX, COUNT );
+    utf8_erase_bytes_( REAL_FIRST._bpos, REAL_LAST._bpos, REAL_LAST._index - REAL_FIRST._index );
+    return UTF8iterator( _utf8string.data(), _utf8string.size(), REAL_FIRST._bpos, REAL_FIRST._index );
+}
+
+// Remove the bytes [bfirst, blast[, which contain count codepoints
+template <typename Allocator>
+void UTF8basic_string<Allocator>::utf8_erase_bytes_( const size_t bfirst, const size_t blast, const size_t count ) noexcept
+{
+    _utf8string.erase( bfirst, blast - bfirst );
+    _utf8length -= count;
+    utf8_invalidate_cache_();
 
-    return utf8_begin() + INDEX;
+    // The positions before the erased bytes are still valid
+    while ( !_utf8index.empty() && _utf8index.back() > bfirst )
+        _utf8index.pop_back();
 }
 
-UTF8string UTF8string::utf8_substr( size_t pos, size_t len ) const
+// The byte range is copied as it is, it is not checked again
+template <typename Allocator>
+UTF8basic_string<Allocator> UTF8basic_string<Allocator>::utf8_substr( size_t pos, size_t len ) const
 {
     if ( pos > _utf8length )
-        return UTF8string();
+        return UTF8basic_string();
 
     // Length of the substring (number of code points)
-    const size_t N = ( len == UTF8string::npos || ( pos + len ) > _utf8length ) ?
+    const size_t N = ( len == npos || ( pos + len ) > _utf8length ) ?
                      ( _utf8length - pos ) : len;
 
-    UTF8iterator it = utf8_iterator_() + pos;
-    const UTF8iterator _END = ( it + N );
-    std::string s;
+    const size_t BFIRST = utf8_bpos_at_( pos );
+    const size_t BLAST  = utf8_advance_( BFIRST, N );
+    return UTF8basic_string( _utf8string.data() + BFIRST, BLAST - BFIRST, N );
+}
 
-    while ( it != _END )
-    {
-        s += *( it++ );
-    }
+/*
+    The search is done on the bytes, UTF-8 is self-synchronizing so
+    a byte match is a codepoint match. The position is converted once.
+*/
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_find( const UTF8basic_string& str, size_t pos ) const
+{
+    if ( str._utf8length == 0 || pos > _utf8length || str._utf8length > _utf8length - pos )
+        return npos;
+
+    const size_t BPOS = utf8_bpos_at_( pos );
+    const char * const DATA = _utf8string.data() + BPOS;
+    const size_t FOUND = utf8_kernel::find( DATA, _utf8string.size() - BPOS,
+                                            str._utf8string.data(), str._utf8string.size() );
+
+    if ( FOUND == utf8_kernel::npos )
+        return npos;
 
-    return UTF8string( s );
+    return pos + utf8_count_( DATA, FOUND );
 }
 
-// This function implements the Boyer-Moore string search algorithm
-size_t UTF8string::utf8_find( const UTF8string& str, size_t pos ) const
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_rfind( const UTF8basic_string& str, size_t pos ) const
 {
-    if ( str._utf8length == 0 )
-        return UTF8string::npos;
+    if ( str._utf8length == 0 || str._utf8length > _utf8length )
+        return npos;
 
-    // Preprocessing
-    std::unordered_map<UTF8string::u8char, size_t> u8map;
-    preprocess( str, u8map );
+    // Only the occurrences that start before LAST are in the bytes searched,
+    // the codepoints after LAST may be shorter than the ones of str
+    const size_t LAST  = min( pos, _utf8length - str._utf8length );
+    const size_t BSIZE = min( utf8_bpos_at_( LAST ) + str._utf8string.size(), _utf8string.size() );
+    const size_t FOUND = utf8_kernel::rfind( _utf8string.data(), BSIZE,
+                                             str._utf8string.data(), str._utf8string.size() );
 
-    const size_t U8LEN = str._utf8length;
-    size_t index = pos;
+    if ( FOUND == utf8_kernel::npos )
+        return npos;
 
-    // Look for the subtring
-    while ( index <= _utf8length - U8LEN )
-    {
-        size_t j = U8LEN - 1;
-        bool found = false;
+    // Count from the end, the occurrence is usually closer to it
+    return _utf8length - utf8_count_( _utf8string.data() + FOUND, _utf8string.size() - FOUND );
+}
 
-        while ( ( str.utf8_at( j ) == utf8_at( index + j ) ) )
-        {
-            if ( j == 0 )
-            {
-                found = true;
-                break;
-            }
+/*
+    The byte cursor and the codepoint cursor go forward together,
+    so each byte is read once by the search and once by the count
+*/
+template <typename Allocator>
+std::vector<size_t> UTF8basic_string<Allocator>::utf8_find_all( const UTF8basic_string& str, size_t pos ) const
+{
+    std::vector<size_t> positions;
 
-            j--;
-        }
+    if ( str._utf8length == 0 || pos > _utf8length )
+        return positions;
 
-        if ( !found )
-        {
-            UTF8string::u8char ss = utf8_at( index + j );
-            index += ( u8map.find( ss ) == u8map.end() ) ? U8LEN : u8map[ss];
-        }
-        else
-            return index;
+    const char * const DATA  = _utf8string.data();
+    const size_t SIZE  = _utf8string.size();
+    const size_t NSIZE = str._utf8string.size();
+    const size_t PROBE = utf8_kernel::probe( str._utf8string.data(), NSIZE );
+    size_t bpos = utf8_bpos_at_( pos );
+    size_t cpos = pos;
+
+    while ( true )
+    {
+        const size_t FOUND = utf8_kernel::find( DATA + bpos, SIZE - bpos, str._utf8string.data(), NSIZE, PROBE );
+
+        if ( FOUND == utf8_kernel::npos )
+            break;
+
+        cpos += utf8_count_( DATA + bpos, FOUND );
+        positions.push_back( cpos );
+        bpos += FOUND + NSIZE;
+        cpos += str._utf8length;
     }
 
-    return UTF8string::npos;
+    return positions;
 }
 
-// Tail-recursive function that reverse the string
-UTF8string UTF8string::utf8_reverse_aux_( UTF8iterator& it, const UTF8iterator& _end, UTF8string& res )
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_count( const UTF8basic_string& str ) const
 {
-    if ( it == _end )
-        return res;
+    if ( str._utf8length == 0 )
+        return 0;
 
-    res += *( --it );
-    return utf8_reverse_aux_( it, _end, res );
-}
+    const char * const DATA  = _utf8string.data();
+    const size_t SIZE  = _utf8string.size();
+    const size_t NSIZE = str._utf8string.size();
+    const size_t PROBE = utf8_kernel::probe( str._utf8string.data(), NSIZE );
+    size_t bpos = 0;
+    size_t n = 0;
+
+    while ( true )
+    {
+        const size_t FOUND = utf8_kernel::find( DATA + bpos, SIZE - bpos, str._utf8string.data(), NSIZE, PROBE );
+
+        if ( FOUND == utf8_kernel::npos )
+            return n;
 
+        bpos += FOUND + NSIZE;
+        n += 1;
+    }
+}
 
-UTF8string& UTF8string::utf8_reverse()
+/*
+    The bytes are reversed, then the bytes of each multi-byte codepoint
+    are put back in order. In the reversed buffer, a codepoint is
+    its continuation bytes followed by its first byte.
+*/
+template <typename Allocator>
+UTF8basic_string<Allocator>& UTF8basic_string<Allocator>::utf8_reverse()
 {
     if ( _utf8length > 1 )
     {
-        UTF8iterator it = utf8_end();
-        UTF8string rev;
-        _utf8string = ( utf8_reverse_aux_( it, utf8_iterator_(), rev ) )._utf8string;
+        std::reverse( _utf8string.begin(), _utf8string.end() );
+
+        // An ASCII string has no multi-byte codepoint
+        const size_t U8SIZE = utf8_is_ascii() ? 0U : _utf8string.size();
+        size_t i = 0;
+
+        while ( i < U8SIZE )
+        {
+            size_t j = i;
+
+            while ( ( 0xc0 & static_cast<byte_t>( _utf8string[j] ) ) == 0x80 )
+                j += 1;
+
+            if ( j > i )
+                std::reverse( _utf8string.begin() + static_cast<long>( i ),
+                              _utf8string.begin() + static_cast<long>( j + 1 ) );
+            i = j + 1;
+        }
+
+        utf8_invalidate_();
     }
 
     return *this;
 }
 
 
-size_t UTF8string::utf8_size() const noexcept
+// Byte order, the shortest string is first if it is a prefix of the other one
+template <typename Allocator>
+int UTF8basic_string<Allocator>::utf8_compare_( const char * data, const size_t size ) const noexcept
 {
-    return _utf8string.size();
-}
+    const size_t U8SIZE = _utf8string.size();
+    const size_t N = min( U8SIZE, size );
+    const int CMP = N == 0 ? 0 : std::memcmp( _utf8string.data(), data, N );
 
+    if ( CMP != 0 )
+        return CMP;
 
-size_t UTF8string::utf8_length() const noexcept
-{
-    return _utf8length;
+    return U8SIZE < size ? -1 : ( U8SIZE > size ? 1 : 0 );
 }
 
-const std::string UTF8string::utf8_sstring() const noexcept
+// The sizes are compared first, the bytes are only compared if they are the same
+template <typename Allocator>
+bool UTF8basic_string<Allocator>::utf8_equals_( const char * data, const size_t size ) const noexcept
 {
-    return _utf8string;
+    return _utf8string.size() == size && ( size == 0 || std::memcmp( _utf8string.data(), data, size ) == 0 );
 }
 
-const char * UTF8string::utf8_str() const noexcept
+template <typename Allocator>
+int UTF8basic_string<Allocator>::utf8_compare( const UTF8basic_string& str ) const noexcept
 {
-    return _utf8string.c_str();
+    return utf8_compare_( str._utf8string.data(), str._utf8string.size() );
 }
 
-size_t UTF8string::hash() const noexcept
+template <typename Allocator>
+int UTF8basic_string<Allocator>::utf8_compare( const UTF8string_view& str ) const noexcept
 {
-    // computes the hash using a variant
-    // of the Fowler-Noll-Vo hash function
-    const size_t MAGIC = 16777619U;
-    size_t result = 2166136261U;
-
-    for ( const char& c : _utf8string )
-    {
-        result = ( result * MAGIC ) ^ static_cast<decltype( result )>( c );
-    }
-    return result ^ ( _utf8length << 1 );
+    return utf8_compare_( str.utf8_data(), str.utf8_size() );
 }
 
-// Internal function that creates an iterator of the current string
-UTF8iterator UTF8string::utf8_iterator_() const noexcept
+template <typename Allocator>
+int UTF8basic_string<Allocator>::utf8_compare( const std::string& str ) const noexcept
 {
-    return UTF8iterator( *this );
+    return utf8_compare_( str.data(), str.size() );
 }
 
-
-UTF8iterator UTF8string::utf8_begin() const noexcept
+template <typename Allocator>
+int UTF8basic_string<Allocator>::utf8_compare( const char * str ) const noexcept
 {
-    return utf8_iterator_();
+    return utf8_compare_( str, std::strlen( str ) );
 }
 
 
-UTF8iterator UTF8string::utf8_end() const noexcept
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_size() const noexcept
 {
-    return utf8_begin() + _utf8length;
+    return _utf8string.size();
 }
 
 
-UTF8iterator UTF8string::begin() const noexcept
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::utf8_length() const noexcept
 {
-    return utf8_begin();
+    return _utf8length;
 }
 
-
-UTF8iterator UTF8string::end() const noexcept
+// Every codepoint takes at least one byte, they all take one byte if they are ASCII
+template <typename Allocator>
+bool UTF8basic_string<Allocator>::utf8_is_ascii() const noexcept
 {
-    return utf8_begin() + _utf8length;
+    return _utf8length == _utf8string.size();
 }
 
-
-bool operator ==( const UTF8string& str1, const UTF8string& str2 ) noexcept
+template <typename Allocator>
+const typename UTF8basic_string<Allocator>::u8string UTF8basic_string<Allocator>::utf8_sstring() const & noexcept
 {
-    return str1.utf8_sstring() == str2.utf8_sstring();
+    return _utf8string;
 }
 
-bool operator !=( const UTF8string& str1, const UTF8string& str2 ) noexcept
+template <typename Allocator>
+typename UTF8basic_string<Allocator>::u8string UTF8basic_string<Allocator>::utf8_sstring() && noexcept
 {
-    return !( str1 == str2 );
+    u8string s( std::move( _utf8string ) );
+    utf8_clear();
+    return s;
 }
 
-
-bool operator <=( const UTF8string& str1, const UTF8string& str2 ) noexcept
+template <typename Allocator>
+std::u16string UTF8basic_string<Allocator>::utf8_to_u16() const
 {
-    return str1.utf8_sstring() <= str2.utf8_sstring();
+    const size_t UNITS = utf8_is_ascii() ? _utf8length : utf8_kernel::units_u16( _utf8string.data(), _utf8string.size() );
+    std::u16string s( UNITS, u'\0' );
+    utf8_kernel::decode_u16( _utf8string.data(), _utf8string.size(), &s[0] );
+    return s;
 }
 
-
-bool operator >=( const UTF8string& str1, const UTF8string& str2 ) noexcept
+template <typename Allocator>
+std::u32string UTF8basic_string<Allocator>::utf8_to_u32() const
 {
-    return str1.utf8_sstring() >= str2.utf8_sstring();
+    std::u32string s( _utf8length, U'\0' );
+    utf8_kernel::decode_u32( _utf8string.data(), _utf8string.size(), &s[0] );
+    return s;
 }
 
-
-bool operator <( const UTF8string& str1, const UTF8string& str2 ) noexcept
+// The length comes from the check, the converted string is valid
+template <typename Allocator>
+UTF8basic_string<Allocator> UTF8basic_string<Allocator>::from_u16( const std::u16string& str, const Allocator& alloc )
 {
-    return str1.utf8_sstring() < str2.utf8_sstring();
-}
+    size_t len = 0;
+    const size_t SIZE = utf8_kernel::size_u16( str.data(), str.size(), len );
 
+    if ( SIZE == utf8_kernel::npos )
+        throw std::invalid_argument( "Invalid UTF-16 string\n" );
 
-bool operator >( const UTF8string& str1, const UTF8string& str2 ) noexcept
-{
-    return str1.utf8_sstring() > str2.utf8_sstring();
+    UTF8basic_string u8( alloc );
+    u8._utf8string.resize( SIZE );
+    utf8_kernel::encode_u16( str.data(), str.size(), &u8._utf8string[0] );
+    u8._utf8length = len;
+    return u8;
 }
 
+template <typename Allocator>
+UTF8basic_string<Allocator> UTF8basic_string<Allocator>::from_u32( const std::u32string& str, const Allocator& alloc )
+{
+    const size_t SIZE = utf8_kernel::size_u32( str.data(), str.size() );
+
+    if ( SIZE == utf8_kernel::npos )
+        throw std::invalid_argument( "Invalid UTF-32 string\n" );
 
-UTF8string operator +( const UTF8string& str1, const UTF8string& str2 )
+    UTF8basic_string u8( alloc );
+    u8._utf8string.resize( SIZE );
+    utf8_kernel::encode_u32( str.data(), str.size(), &u8._utf8string[0] );
+    u8._utf8length = str.size();
+    return u8;
+}
+
+template <typename Allocator>
+const char * UTF8basic_string<Allocator>::utf8_str() const noexcept
 {
-    return str1 + str2.utf8_sstring();
+    return _utf8string.c_str();
 }
 
+template <typename Allocator>
+size_t UTF8basic_string<Allocator>::hash() const noexcept
+{
+    // 0 is also a possible hash value, it is just computed again
+    size_t h = _utf8hash.load( std::memory_order_relaxed );
+
+    if ( h == 0U )
+    {
+        // Two threads may compute the same value, it is stored twice
+        h = utf8_kernel::hash( _utf8string.data(), _utf8string.size() );
+        _utf8hash.store( h, std::memory_order_relaxed );
+    }
+
+    return h;
+}
 
-UTF8string operator +( const UTF8string& str1, const std::string& str2 )
+template <typename Allocator>
+Allocator UTF8basic_string<Allocator>::get_allocator() const noexcept
 {
-    return UTF8string( str1.utf8_sstring() + str2 );
+    return _utf8string.get_allocator();
 }
 
-UTF8string operator +( const std::string& str1, const UTF8string& str2 )
+// Internal function that creates an iterator of the current string
+template <typename Allocator>
+UTF8iterator UTF8basic_string<Allocator>::utf8_iterator_() const noexcept
 {
-    return UTF8string( str1 + str2.utf8_sstring() );
+    return UTF8iterator( *this );
 }
 
 
-UTF8string operator +( const UTF8string& str1, const char * str2 )
+template <typename Allocator>
+UTF8iterator UTF8basic_string<Allocator>::utf8_begin() const noexcept
 {
-    return str1 + std::string( str2 );
+    return utf8_iterator_();
 }
 
 
-UTF8string operator +( const char * str1, const UTF8string& str2 )
+template <typename Allocator>
+UTF8iterator UTF8basic_string<Allocator>::utf8_end() const noexcept
 {
-    return std::string( str1 ) + str2;
+    return UTF8iterator( _utf8string.data(), _utf8string.size(),
+                         _utf8string.size(), _utf8length );
 }
 
 
-std::ostream& operator <<( std::ostream& os, const UTF8string& str )
+template <typename Allocator>
+UTF8iterator UTF8basic_string<Allocator>::begin() const noexcept
 {
-    os << str.utf8_sstring();
-    return os;
+    return utf8_begin();
 }
 
 
-std::istream& operator >>( std::istream& is, UTF8string& str )
+template <typename Allocator>
+UTF8iterator UTF8basic_string<Allocator>::end() const noexcept
 {
-    std::string tmp;
-    std::getline( is, tmp );
-    str = tmp;
-    return is;
+    return utf8_end();
 }
+
+
+template class UTF8basic_string<std::allocator<char>>;
+
+#if defined( UTF8_STRING_PMR )
+template class UTF8basic_string<std::pmr::polymorphic_allocator<char>>;
+#endif
@@ -19,42 +19,119 @@
 *   @brief This is a UTF-8 string library header
 */
 
+#include "utf8_char.hpp"
+#include "utf8_error.hpp"
+
 #include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
 #include <iostream>
+#include <stdexcept>
+
+/*
+    UTF8pmr_string is only compiled if UTF8_STRING_PMR is defined
+    for the library and for the code that uses it (C++17)
+*/
+#if defined( UTF8_STRING_PMR )
+#if __cplusplus < 201703L
+#error "UTF8_STRING_PMR needs C++17"
+#endif
+#include <memory_resource>
+#endif
 
 class UTF8iterator;
+class UTF8string_view;
+
+template <typename Allocator = std::allocator<char>>
+class UTF8basic_result;
 
 /**
-*   @class UTF8string final
+*   @class UTF8basic_string final
 *   @brief UTF-8 string class
 *
-*   This class defines a UTF-8 string
+*   This class defines a UTF-8 string, its memory is managed by *Allocator*.
+*   Use the UTF8string alias (std::allocator), or UTF8pmr_string
+*   (std::pmr::polymorphic_allocator, C++17) to allocate the strings
+*   from a memory resource. UTF8pmr_string is only available if
+*   UTF8_STRING_PMR is defined when the library is compiled.
+*
+*   The member functions are compiled in utf8_string.cpp, so only
+*   these two allocators can be used.
+*
+*   Large strings build an index of the codepoint positions on the first
+*   random access, so utf8_at() and operator [] run in constant time.
+*   The hash value is also kept by the string. Both are built inside
+*   const member functions, the index under a lock and the hash value
+*   in an atomic, so several threads can read the same string
+*   like a std::string.
 */
-class UTF8string final
+template <typename Allocator = std::allocator<char>>
+class UTF8basic_string final
 {
+public:
+
+    /**
+    *   @typedef allocator_type
+    *   @brief The allocator of the string
+    */
+    using allocator_type = Allocator;
+    /**
+    *   @typedef u8string
+    *   @brief The type of the internal string (std::string for UTF8string)
+    */
+    using u8string = std::basic_string<char, std::char_traits<char>, Allocator>;
+
+private:
+
     using byte_t = unsigned char;
-    using u8string = std::string;
+    using index_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<size_t>;
+    // The buffer of a moved string is taken if the allocator follows it or if
+    // the allocators are always equal, it is copied otherwise (pmr)
+    static constexpr bool UTF8_MOVE_NOEXCEPT =
+        std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+        || std::allocator_traits<Allocator>::is_always_equal::value;
 
     u8string _utf8string = {};
     size_t _utf8length = 0U;
+    // Byte position of every UTF8_INDEX_STEP-th codepoint (built lazily)
+    mutable std::vector<size_t, index_allocator> _utf8index = {};
+    // The index is complete, the samples can be read without the lock
+    mutable std::atomic<bool> _utf8indexed{ false };
+    // Hash value of the content (computed lazily), 0 if it is not known.
+    // Readers of a shared string may compute it at the same time.
+    mutable std::atomic<size_t> _utf8hash{ 0U };
+
+    UTF8basic_string( const char * data, const size_t size, const size_t length,
+                      const Allocator& alloc = Allocator() );
 
-    bool utf8_is_valid_() const noexcept;
-    size_t utf8_length_() const noexcept;
+    static size_t utf8_validate_( const char * data, const size_t size );
     size_t utf8_codepoint_len_( const size_t j ) const noexcept;
     size_t utf8_bpos_at_( const size_t cpos ) const noexcept;
-    u8string utf8_at_( const size_t index ) const noexcept;
+    size_t utf8_advance_( const size_t bpos, const size_t n ) const noexcept;
+    size_t utf8_count_( const char * data, const size_t size ) const noexcept;
+    void utf8_index_() const;
+    void utf8_invalidate_() noexcept;
+    void utf8_invalidate_cache_() noexcept;
+    int utf8_compare_( const char * data, const size_t size ) const noexcept;
+    bool utf8_equals_( const char * data, const size_t size ) const noexcept;
+    void utf8_erase_bytes_( const size_t bfirst, const size_t blast, const size_t count ) noexcept;
+    UTF8char utf8_at_( const size_t index ) const noexcept;
 
     UTF8iterator utf8_iterator_() const noexcept;
-    UTF8string utf8_reverse_aux_( UTF8iterator& it,
-                                  const UTF8iterator& _end, UTF8string& res );
+
+    friend class UTF8searcher;
+    friend class UTF8builder;
 
 public:
 
     /**
     *   @typedef u8char
     *   @brief The UTF-8 character
+    *
+    *   A codepoint stored by value, it can be converted into a std::string
     */
-    using u8char = std::string;
+    using u8char = UTF8char;
 
     /**
     *   @var npos
@@ -75,80 +152,119 @@ public:
     constexpr static size_t npos = std::string::npos;
 
     /**
-    *   @fn UTF8string() = default
+    *   @fn UTF8basic_string() = default
     */
-    UTF8string() = default;
+    UTF8basic_string() = default;
     /**
-    *   @fn UTF8string(const char * str)
+    *   @fn explicit UTF8basic_string(const Allocator& alloc) noexcept
+    *   Build an empty string that uses an allocator
+    *   @param alloc
+    */
+    explicit UTF8basic_string( const Allocator& alloc ) noexcept;
+    /**
+    *   @fn UTF8basic_string(const char * str, const Allocator& alloc = Allocator())
     *   @param str
+    *   @param alloc
     *   @pre str is not null
     *   @exception std::invalid_argument If the string is not valid
     */
-    UTF8string( const char * str );
+    UTF8basic_string( const char * str, const Allocator& alloc = Allocator() );
+    /**
+    *   @fn UTF8basic_string(const std::string& str, const Allocator& alloc = Allocator())
+    *   @param str
+    *   @param alloc
+    *   @exception std::invalid_argument If the string is not valid
+    */
+    UTF8basic_string( const std::string& str, const Allocator& alloc = Allocator() );
     /**
-    *   @fn UTF8string(const std::string& str)
+    *   @fn UTF8basic_string(std::string&& str, const Allocator& alloc = Allocator())
+    *
+    *   Take the buffer of the string, nothing is copied
+    *   (the content is copied if the allocator is not std::allocator).
+    *
     *   @param str
+    *   @param alloc
     *   @exception std::invalid_argument If the string is not valid
+    *   @note If an exception is thrown, *str* is not modified
     */
-    UTF8string( const std::string& str );
+    UTF8basic_string( std::string&& str, const Allocator& alloc = Allocator() );
     /**
-    *   @fn UTF8string(const UTF8string& u8str) noexcept
+    *   @fn UTF8basic_string(const UTF8basic_string& u8str) noexcept
     *   @param u8str
     */
-    UTF8string( const UTF8string& u8str ) noexcept;
+    UTF8basic_string( const UTF8basic_string& u8str ) noexcept;
     /**
-    *   @fn UTF8string(const UTF8string& u8str, size_t pos, size_t len = npos) noexcept
+    *   @fn UTF8basic_string(const UTF8basic_string& u8str, size_t pos, size_t len = npos) noexcept
     *   @param u8str
     *   @param pos The beginning position of the substring
     *   @param len The length of the substring (in number of codepoints, default value = npos)
     */
-    UTF8string( const UTF8string& u8str, size_t pos, size_t len = npos ) noexcept;
+    UTF8basic_string( const UTF8basic_string& u8str, size_t pos, size_t len = npos ) noexcept;
     /**
-    *   @fn UTF8string(UTF8string&& u8str) noexcept
-    *   @param u8str
+    *   @fn UTF8basic_string(UTF8basic_string&& u8str) noexcept
+    *   @param u8str The string to move from, it is empty after the call
     */
-    UTF8string( UTF8string&& u8str ) noexcept;
+    UTF8basic_string( UTF8basic_string&& u8str ) noexcept;
+    /**
+    *   @fn explicit UTF8basic_string(const UTF8string_view& u8view, const Allocator& alloc = Allocator())
+    *
+    *   Copy the content of a view. The content is not checked again.
+    *
+    *   @param u8view The view
+    *   @param alloc
+    */
+    explicit UTF8basic_string( const UTF8string_view& u8view, const Allocator& alloc = Allocator() );
 
     /**
-    *   @fn UTF8string& operator =(const char * str)
+    *   @fn UTF8basic_string& operator =(const char * str)
     *   @param str C-string that will be converted
     *   @return A reference to the new utf-8 string
     *   @exception std::invalid_argument If the string is not valid
     *   @note If an exception is thrown, the object in not modified
     */
-    UTF8string& operator =( const char * str );
+    UTF8basic_string& operator =( const char * str );
     /**
-    *   @fn UTF8string& operator =(const std::string& str)
+    *   @fn UTF8basic_string& operator =(const std::string& str)
     *   @param str The string that will be converted and checked
     *   @return A reference to the new utf-8 string
     *   @exception std::invalid_argument If the string is not valid
     *   @note If an exception is thrown, the object in not modified
     */
-    UTF8string& operator =( const std::string& str );
+    UTF8basic_string& operator =( const std::string& str );
     /**
-    *   @fn UTF8string& operator =(const UTF8string& u8str)
-    *   @param u8str The utf-8 string
+    *   @fn UTF8basic_string& operator =(std::string&& str)
+    *   @param str The string that will be checked and moved
     *   @return A reference to the new utf-8 string
+    *   @exception std::invalid_argument If the string is not valid
+    *   @note If an exception is thrown, the object and *str* are not modified
     */
-    UTF8string& operator =( const UTF8string& u8str ) noexcept;
+    UTF8basic_string& operator =( std::string&& str );
     /**
-    *   @fn UTF8string& operator =(UTF8string&& u8str)
+    *   @fn UTF8basic_string& operator =(const UTF8basic_string& u8str)
     *   @param u8str The utf-8 string
     *   @return A reference to the new utf-8 string
     */
-    UTF8string& operator =( UTF8string&& u8str ) noexcept;
+    UTF8basic_string& operator =( const UTF8basic_string& u8str ) noexcept;
+    /**
+    *   @fn UTF8basic_string& operator =(UTF8basic_string&& u8str) noexcept(UTF8_MOVE_NOEXCEPT)
+    *   @param u8str The utf-8 string, it is empty after the call
+    *   @return A reference to the new utf-8 string
+    *   @exception std::bad_alloc If the allocators are different (pmr)
+    *              and the content cannot be copied
+    */
+    UTF8basic_string& operator =( UTF8basic_string&& u8str ) noexcept( UTF8_MOVE_NOEXCEPT );
 
     /**
-    *   @fn const UTF8string& operator +=(const UTF8string& u8str)
+    *   @fn const UTF8basic_string& operator +=(const UTF8basic_string& u8str)
     *
     *   Append a utf-8 string
     *
     *   @param u8str The string to convert from
     *   @return The reference to the concatenated utf-8 string
     */
-    const UTF8string& operator +=( const UTF8string& u8str );
+    const UTF8basic_string& operator +=( const UTF8basic_string& u8str );
     /**
-    *   @fn const UTF8string& operator +=(const std::string& str)
+    *   @fn const UTF8basic_string& operator +=(const std::string& str)
     *
     *   Append a string
     *
@@ -157,17 +273,18 @@ public:
     *   @exception std::invalid_argument If the string is not valid
     *   @note If an exception is thrown, the object in not modified
     */
-    const UTF8string& operator +=( const std::string& str );
+    const UTF8basic_string& operator +=( const std::string& str );
     /**
-    *   @fn const UTF8string& operator +=(const char * str)
+    *   @fn const UTF8basic_string& operator +=(const char * str)
     *
     *   Append a C-string
     *
     *   @param str The string to convert from
     *   @return The reference to the concatenated utf-8 string
     *   @exception std::invalid_argument If the string is not valid
+    *   @note If an exception is thrown, the object in not modified
     */
-    const UTF8string& operator +=( const char * str );
+    const UTF8basic_string& operator +=( const char * str );
 
     /**
     *   @fn void utf8_clear() noexcept
@@ -185,17 +302,27 @@ public:
 
 
     /**
-    *   @fn UTF8string& utf8_assign(const char * str)
+    *   @fn UTF8basic_string& utf8_assign(const char * str)
     *   @return The updated string
     */
-    UTF8string& utf8_assign( const char * str );
+    UTF8basic_string& utf8_assign( const char * str );
     /**
-    *   @fn UTF8string& utf8_assign(const u8string& str)
+    *   @fn UTF8basic_string& utf8_assign(const std::string& str)
     *   @return The updated string
     */
-    UTF8string& utf8_assign( const u8string& str );
+    UTF8basic_string& utf8_assign( const std::string& str );
     /**
-    *   @fn UTF8string& utf8_assign(const u8string& str, size_t pos, size_t count = npos)
+    *   @fn UTF8basic_string& utf8_assign(std::string&& str)
+    *
+    *   Take the buffer of str if it is valid.
+    *
+    *   @exception std::invalid_argument If the string is not valid
+    *   @note If an exception is thrown, the object and *str* are not modified
+    *   @return The updated string
+    */
+    UTF8basic_string& utf8_assign( std::string&& str );
+    /**
+    *   @fn UTF8basic_string& utf8_assign(const std::string& str, size_t pos, size_t count = npos)
     *
     *   Replaces the contents with a substring [pos, pos+count) of str.
     *   If the requested substring lasts past the end of the string, or if count == npos, the resulting substring is [pos, str.size()).
@@ -203,15 +330,20 @@ public:
     *   @exception std::out_of_range If pos > str.size()
     *   @return The updated string
     */
-    UTF8string& utf8_assign( const u8string& str, size_t pos, size_t count = npos );
+    UTF8basic_string& utf8_assign( const std::string& str, size_t pos, size_t count = npos );
     /**
-    *   @fn UTF8string& utf8_assign(UTF8string&& u8str) noexcept
+    *   @fn UTF8basic_string& utf8_assign(UTF8basic_string&& u8str) noexcept(UTF8_MOVE_NOEXCEPT)
+    *
+    *   Take the content of u8str in constant time, u8str is empty after the call.
+    *   If the allocators are different (pmr), the content is copied.
+    *
     *   @return The updated string
+    *   @exception std::bad_alloc If the content is copied and cannot be allocated
     */
-    UTF8string& utf8_assign( UTF8string&& u8str ) noexcept;
+    UTF8basic_string& utf8_assign( UTF8basic_string&& u8str ) noexcept( UTF8_MOVE_NOEXCEPT );
 
     /**
-    *   @fn UTF8string::u8char utf8_at(const size_t index) const
+    *   @fn u8char utf8_at(const size_t index) const
     *
     *   Get the codepoint at a specified position.
     *
@@ -220,9 +352,9 @@ public:
     *   @exception std::out_of_range If the index is out of the string range
     *   @note If an exception is thrown, the object in not modified
     */
-    UTF8string::u8char utf8_at( const size_t index ) const;
+    u8char utf8_at( const size_t index ) const;
     /**
-    *   @fn UTF8string::u8char operator [](const size_t index) const noexcept
+    *   @fn u8char operator [](const size_t index) const noexcept
     *
     *   Get the codepoint at a specified position.
     *
@@ -232,7 +364,7 @@ public:
     *   @note If the index is out of the string range, calling this functions
     *         causes undefined behaviour
     */
-    UTF8string::u8char operator []( const size_t index ) const noexcept;
+    u8char operator []( const size_t index ) const noexcept;
     /**
     *   @fn void utf8_pop()
     *
@@ -243,7 +375,7 @@ public:
     */
     void utf8_pop();
     /**
-    *   @fn UTF8string& utf8_erase(const size_t index = 0, const size_t count = npos)
+    *   @fn UTF8basic_string& utf8_erase(const size_t index = 0, const size_t count = npos)
     *
     *   Removes min(count, utf8_size() - index) characters starting at index
     *
@@ -251,7 +383,7 @@ public:
     *   @exception std::out_of_range if ```index > utf8_size()```
     *   @note If an exception is thrown, the object in not modified
     */
-    UTF8string& utf8_erase( const size_t index = 0, const size_t count = npos );
+    UTF8basic_string& utf8_erase( const size_t index = 0, const size_t count = npos );
     /**
     *   @fn UTF8iterator utf8_erase(const UTF8iterator& position)
     *
@@ -272,9 +404,22 @@ public:
     *   @note If one of the iterators does not point to *this, the behaviour is undefined
     */
     UTF8iterator utf8_erase( const UTF8iterator& first, const UTF8iterator& last );
+    /**
+    *   @fn template <typename Predicate> size_t utf8_erase_if(Predicate pred)
+    *
+    *   Removes every codepoint for which ```pred(c)``` returns TRUE,
+    *   in one pass and without any allocation.
+    *
+    *   @param pred The function called with each codepoint (```const UTF8char&```)
+    *   @return The number of codepoints removed
+    *   @note If pred throws an exception, the codepoints already checked
+    *         are removed or kept according to pred, the other ones are kept
+    */
+    template <typename Predicate>
+    size_t utf8_erase_if( Predicate pred );
 
     /**
-    *   @fn UTF8string utf8_substr(size_t pos = 0, size_t len = npos) const
+    *   @fn UTF8basic_string utf8_substr(size_t pos = 0, size_t len = npos) const
     *
     *   Generate a substring according to the position and the length requested.
     *
@@ -286,9 +431,9 @@ public:
     *   @param len The length of the substring (in number of codepoints, default value = npos)
     *   @return The substring
     */
-    UTF8string utf8_substr( size_t pos = 0, size_t len = npos ) const;
+    UTF8basic_string utf8_substr( size_t pos = 0, size_t len = npos ) const;
     /**
-    *   @fn size_t utf8_find(const UTF8string& str, size_t pos = 0) const
+    *   @fn size_t utf8_find(const UTF8basic_string& str, size_t pos = 0) const
     *
     *   Search for the first occurrence of utf8 string
     *   specified in argument.
@@ -300,15 +445,81 @@ public:
     *   @param str The string to look for
     *   @param pos The position to start the search
     *   @return The position of the substring if it was found
-    *           (in number of codepoints), UTF8string::npos otherwise.
+    *           (in number of codepoints), npos otherwise.
+    */
+    size_t utf8_find( const UTF8basic_string& str, size_t pos = 0 ) const;
+    /**
+    *   @fn size_t utf8_rfind(const UTF8basic_string& str, size_t pos = npos) const
+    *
+    *   Search for the last occurrence of utf8 string
+    *   specified in argument.
+    *
+    *   When pos is specified, the search only includes occurrences
+    *   that start at or before position pos.
+    *
+    *   @param str The string to look for
+    *   @param pos The last position where the substring can start
+    *   @return The position of the substring if it was found
+    *           (in number of codepoints), npos otherwise.
+    */
+    size_t utf8_rfind( const UTF8basic_string& str, size_t pos = npos ) const;
+    /**
+    *   @fn std::vector<size_t> utf8_find_all(const UTF8basic_string& str, size_t pos = 0) const
+    *
+    *   Search for every occurrence of utf8 string specified
+    *   in argument, from the position pos, in one pass.
+    *
+    *   The occurrences do not overlap: the search goes on after the end
+    *   of each occurrence ("aa" is found twice in "aaaa", not three times).
+    *
+    *   @param str The string to look for
+    *   @param pos The position to start the search
+    *   @return The positions of the occurrences (in number of codepoints),
+    *           in increasing order.
+    */
+    std::vector<size_t> utf8_find_all( const UTF8basic_string& str, size_t pos = 0 ) const;
+    /**
+    *   @fn size_t utf8_count(const UTF8basic_string& str) const
+    *
+    *   Count the occurrences of utf8 string specified in argument.
+    *   The occurrences do not overlap, as in utf8_find_all().
+    *
+    *   @param str The string to look for
+    *   @return The number of occurrences, 0 if str is empty
     */
-    size_t utf8_find( const UTF8string& str, size_t pos = 0 ) const;
+    size_t utf8_count( const UTF8basic_string& str ) const;
     /**
-    *   @fn UTF8string& utf8_reverse()
-    *   Reverse the current utf-8 string.
+    *   @fn UTF8basic_string& utf8_reverse()
+    *   Reverse the current utf-8 string, in place.
     *   @return The reversed string
     */
-    UTF8string& utf8_reverse();
+    UTF8basic_string& utf8_reverse();
+
+    /**
+    *   @fn int utf8_compare(const UTF8basic_string& str) const noexcept
+    *
+    *   Compare the utf-8 string with another one, byte by byte.
+    *   The order of the bytes is the order of the codepoints.
+    *
+    *   @param str The utf-8 string to compare with
+    *   @return A negative value if the current string is before *str*,
+    *           0 if they are equals, a positive value otherwise
+    */
+    int utf8_compare( const UTF8basic_string& str ) const noexcept;
+    /**
+    *   @fn int utf8_compare(const UTF8string_view& str) const noexcept
+    */
+    int utf8_compare( const UTF8string_view& str ) const noexcept;
+    /**
+    *   @fn int utf8_compare(const std::string& str) const noexcept
+    *   @note The string is not checked, no utf-8 string is built
+    */
+    int utf8_compare( const std::string& str ) const noexcept;
+    /**
+    *   @fn int utf8_compare(const char * str) const noexcept
+    *   @note The string is not checked, no utf-8 string is built
+    */
+    int utf8_compare( const char * str ) const noexcept;
 
     /**
     *   @fn size_t utf8_size() const noexcept
@@ -322,15 +533,161 @@ public:
     *   @return The length of the utf-8 string (in number of codepoints)
     */
     size_t utf8_length() const noexcept;
+    /**
+    *   @fn bool utf8_is_ascii() const noexcept
+    *
+    *   Check if the string only contains ASCII characters.
+    *   It is known since the string was checked, so this is constant time.
+    *   On such strings, positions are byte positions and the functions
+    *   that take a position (utf8_at(), utf8_substr(), utf8_erase(), ...)
+    *   do not walk the string.
+    *
+    *   @return TRUE if every codepoint is a 7-bit ASCII character, FALSE otherwise
+    */
+    bool utf8_is_ascii() const noexcept;
 
     /**
-    *   @fn const std::string utf8_sstring() const noexcept
+    *   @fn const u8string utf8_sstring() const & noexcept
     *
     *   Returns the string related to the UTF-8 string
     *
+    *   @return The string (std::string for UTF8string)
+    */
+    const u8string utf8_sstring() const & noexcept;
+    /**
+    *   @fn u8string utf8_sstring() && noexcept
+    *
+    *   Give up the internal buffer, nothing is copied.
+    *   The utf-8 string is empty after the call.
+    *
+    *   @return The string (std::string for UTF8string)
+    */
+    u8string utf8_sstring() && noexcept;
+    /**
+    *   @fn static UTF8basic_result<Allocator> try_from(const char * data, const size_t size, const Allocator& alloc = Allocator())
+    *
+    *   Build a utf-8 string without throwing an exception on invalid input.
+    *   The content is checked once, like in the constructors. The error is
+    *   only located if the content is invalid.
+    *
+    *   @param data The content, it is copied if it is valid
+    *   @param size The size of the content (in bytes)
+    *   @param alloc
+    *   @return The string, or the kind and the position of the first
+    *           invalid sequence
+    *   @exception std::bad_alloc If the string cannot be allocated
+    */
+    static UTF8basic_result<Allocator> try_from( const char * data, const size_t size,
+                                                 const Allocator& alloc = Allocator() );
+    /**
+    *   @fn static UTF8basic_result<Allocator> try_from(const char * str, const Allocator& alloc = Allocator())
+    *   @param str The null-terminated content
+    *   @param alloc
+    *   @return The string, or the kind and the position of the first invalid sequence
+    *   @pre str is not null
+    */
+    static UTF8basic_result<Allocator> try_from( const char * str, const Allocator& alloc = Allocator() );
+    /**
+    *   @fn static UTF8basic_result<Allocator> try_from(const std::string& str, const Allocator& alloc = Allocator())
+    *   @param str The content
+    *   @param alloc
+    *   @return The string, or the kind and the position of the first invalid sequence
+    */
+    static UTF8basic_result<Allocator> try_from( const std::string& str, const Allocator& alloc = Allocator() );
+    /**
+    *   @fn static UTF8basic_result<Allocator> try_from(std::string&& str, const Allocator& alloc = Allocator())
+    *   Take the buffer of the string if it is valid, *str* is not modified otherwise
+    *   @param str The content
+    *   @param alloc
+    *   @return The string, or the kind and the position of the first invalid sequence
+    */
+    static UTF8basic_result<Allocator> try_from( std::string&& str, const Allocator& alloc = Allocator() );
+    /**
+    *   @fn static UTF8basic_string from_lossy(const char * data, const size_t size, const Allocator& alloc = Allocator())
+    *
+    *   Build a utf-8 string from any content. Each maximal invalid subpart
+    *   of the content is replaced by U+FFFD (the Unicode recommendation,
+    *   also used by the WHATWG decoder), so nothing is thrown.
+    *
+    *   Valid content is checked once, as in the constructors. Invalid
+    *   content is repaired and counted in one more pass.
+    *
+    *   @param data The content
+    *   @param size The size of the content (in bytes)
+    *   @param alloc
     *   @return The string
     */
-    const std::string utf8_sstring() const noexcept;
+    static UTF8basic_string from_lossy( const char * data, const size_t size, const Allocator& alloc = Allocator() );
+    /**
+    *   @fn static UTF8basic_string from_lossy(const char * str, const Allocator& alloc = Allocator())
+    *   @param str The null-terminated content
+    *   @param alloc
+    *   @return The string, with U+FFFD in place of the invalid sequences
+    *   @pre str is not null
+    */
+    static UTF8basic_string from_lossy( const char * str, const Allocator& alloc = Allocator() );
+    /**
+    *   @fn static UTF8basic_string from_lossy(const std::string& str, const Allocator& alloc = Allocator())
+    *   @param str The content
+    *   @param alloc
+    *   @return The string, with U+FFFD in place of the invalid sequences
+    */
+    static UTF8basic_string from_lossy( const std::string& str, const Allocator& alloc = Allocator() );
+    /**
+    *   @fn static UTF8basic_string from_lossy(std::string&& str, const Allocator& alloc = Allocator())
+    *   Take the buffer of the string if it is valid, nothing is allocated.
+    *   A new buffer is only allocated if the content is repaired.
+    *   @param str The content
+    *   @param alloc
+    *   @return The string, with U+FFFD in place of the invalid sequences
+    */
+    static UTF8basic_string from_lossy( std::string&& str, const Allocator& alloc = Allocator() );
+    /**
+    *   @fn std::u16string utf8_to_u16() const
+    *
+    *   Convert the string into UTF-16. The result is allocated once,
+    *   its size is the length of the string if it only contains
+    *   ASCII characters.
+    *
+    *   @return The UTF-16 string
+    */
+    std::u16string utf8_to_u16() const;
+    /**
+    *   @fn std::u32string utf8_to_u32() const
+    *
+    *   Convert the string into UTF-32. The result is allocated once,
+    *   its size is the length of the string.
+    *
+    *   @return The UTF-32 string
+    */
+    std::u32string utf8_to_u32() const;
+    /**
+    *   @fn static UTF8basic_string from_u16(const std::u16string& str, const Allocator& alloc = Allocator())
+    *
+    *   Build a utf-8 string from a UTF-16 string. The UTF-16 string
+    *   is checked and measured in one pass, then it is converted into
+    *   a buffer of the right size. The result is not checked again.
+    *
+    *   @param str The UTF-16 string
+    *   @param alloc
+    *   @return The utf-8 string
+    *   @exception std::invalid_argument If the string contains an unpaired surrogate
+    */
+    static UTF8basic_string from_u16( const std::u16string& str, const Allocator& alloc = Allocator() );
+    /**
+    *   @fn static UTF8basic_string from_u32(const std::u32string& str, const Allocator& alloc = Allocator())
+    *
+    *   Build a utf-8 string from a UTF-32 string. The UTF-32 string
+    *   is checked and measured in one pass, then it is converted into
+    *   a buffer of the right size. The result is not checked again.
+    *
+    *   @param str The UTF-32 string
+    *   @param alloc
+    *   @return The utf-8 string
+    *   @exception std::invalid_argument If the string contains a surrogate
+    *              or a value greater than U+10FFFF
+    */
+    static UTF8basic_string from_u32( const std::u32string& str, const Allocator& alloc = Allocator() );
     /**
     *   @fn const char * utf8_str() const noexcept
     *
@@ -345,10 +702,19 @@ public:
     const char * utf8_str() const noexcept;
     /**
     *   @fn size_t hash() const noexcept
-    *   Generate a hash value of the utf8 string
-    *   @return The hash value
+    *
+    *   Generate a hash value of the utf8 string.
+    *   The value is kept until the string is modified.
+    *
+    *   @return The hash value, the same as the one of a UTF8string_view
+    *           with the same content
     */
     size_t hash() const noexcept;
+    /**
+    *   @fn Allocator get_allocator() const noexcept
+    *   @return The allocator of the string
+    */
+    Allocator get_allocator() const noexcept;
 
     /**
     *   @fn UTF8iterator utf8_begin() const noexcept
@@ -392,186 +758,611 @@ public:
     */
     UTF8iterator end() const noexcept;
 
-    ~UTF8string() = default;
-};
-
+    /**
+    *   @fn bool operator ==(const UTF8basic_string& str1, const UTF8basic_string& str2) noexcept
+    *
+    *   Check if two utf-8 strings are equals.
+    *
+    *   Two utf-8 strings are equals if and only if they heve the same length
+    *   and have the same sequence of codepoints.
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 utf-8 string
+    *   @return TRUE if they are equals, FALSE otherwise
+    */
+    friend bool operator ==( const UTF8basic_string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        // Two known hash values that differ: the strings differ
+        const size_t H1 = str1._utf8hash.load( std::memory_order_relaxed );
+        const size_t H2 = str2._utf8hash.load( std::memory_order_relaxed );
 
-namespace std
-{
+        if ( H1 != 0U && H2 != 0U && H1 != H2 )
+            return false;
 
-template<>
-class hash<UTF8string>
-{
-public:
-    size_t operator()( const UTF8string& u8str ) const
+        return str1.utf8_equals_( str2._utf8string.data(), str2._utf8string.size() );
+    }
+    /**
+    *   @fn bool operator !=(const UTF8basic_string& str1, const UTF8basic_string& str2) noexcept
+    *
+    *   Check if two utf-8 strings are differents.
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 utf-8 string
+    *   @return TRUE if they are not equals, FALSE otherwise
+    */
+    friend bool operator !=( const UTF8basic_string& str1, const UTF8basic_string& str2 ) noexcept
     {
-        return u8str.hash();
+        return !( str1 == str2 );
+    }
+    /**
+    *   @fn bool operator <=(const UTF8basic_string& str1, const UTF8basic_string& str2) noexcept
+    *
+    *   Check if the first utf-8 string is shorter or equal
+    *   than/to the second utf-8 string
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 utf-8 string
+    *   @return TRUE if the first string is shorter, FALSE otherwise
+    */
+    friend bool operator <=( const UTF8basic_string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) <= 0;
+    }
+    /**
+    *   @fn bool operator >=(const UTF8basic_string& str1, const UTF8basic_string& str2) noexcept
+    *
+    *   Check if the first utf-8 string is longer or equal than/to the second utf-8 string
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 utf-8 string
+    *   @return TRUE if tthe first string is longer, FALSE otherwise
+    */
+    friend bool operator >=( const UTF8basic_string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) >= 0;
+    }
+    /**
+    *   @fn bool operator <(const UTF8basic_string& str1, const UTF8basic_string& str2) noexcept
+    *
+    *   Check if the first utf-8 string is strictly shorter
+    *   than the second utf-8 string
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 utf-8 string
+    *   @return TRUE if the first string is strictly shorter, FALSE otherwise
+    */
+    friend bool operator <( const UTF8basic_string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) < 0;
+    }
+    /**
+    *   @fn bool operator >(const UTF8basic_string& str1, const UTF8basic_string& str2) noexcept
+    *
+    *   Check if the first utf-8 string is strictly longer
+    *   than the second utf-8 string
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 utf-8 string
+    *   @return TRUE if the string is strictly longer, FALSE otherwise
+    */
+    friend bool operator >( const UTF8basic_string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) > 0;
+    }
+    /**
+    *   @fn bool operator ==(const UTF8basic_string& str1, const std::string& str2) noexcept
+    *
+    *   Compare a utf-8 string with the bytes of a string.
+    *   The string is not checked and no utf-8 string is built.
+    *   The other comparison operators with a string work the same way.
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 string
+    *   @return TRUE if they have the same bytes, FALSE otherwise
+    */
+    friend bool operator ==( const UTF8basic_string& str1, const std::string& str2 ) noexcept
+    {
+        return str1.utf8_equals_( str2.data(), str2.size() );
+    }
+    /**
+    *   @fn bool operator !=(const UTF8basic_string& str1, const std::string& str2) noexcept
+    */
+    friend bool operator !=( const UTF8basic_string& str1, const std::string& str2 ) noexcept
+    {
+        return !( str1 == str2 );
+    }
+    /**
+    *   @fn bool operator <(const UTF8basic_string& str1, const std::string& str2) noexcept
+    */
+    friend bool operator <( const UTF8basic_string& str1, const std::string& str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) < 0;
+    }
+    /**
+    *   @fn bool operator >(const UTF8basic_string& str1, const std::string& str2) noexcept
+    */
+    friend bool operator >( const UTF8basic_string& str1, const std::string& str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) > 0;
+    }
+    /**
+    *   @fn bool operator <=(const UTF8basic_string& str1, const std::string& str2) noexcept
+    */
+    friend bool operator <=( const UTF8basic_string& str1, const std::string& str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) <= 0;
+    }
+    /**
+    *   @fn bool operator >=(const UTF8basic_string& str1, const std::string& str2) noexcept
+    */
+    friend bool operator >=( const UTF8basic_string& str1, const std::string& str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) >= 0;
+    }
+    /**
+    *   @fn bool operator ==(const std::string& str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator ==( const std::string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2 == str1;
+    }
+    /**
+    *   @fn bool operator !=(const std::string& str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator !=( const std::string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return !( str2 == str1 );
+    }
+    /**
+    *   @fn bool operator <(const std::string& str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator <( const std::string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2.utf8_compare( str1 ) > 0;
+    }
+    /**
+    *   @fn bool operator >(const std::string& str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator >( const std::string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2.utf8_compare( str1 ) < 0;
+    }
+    /**
+    *   @fn bool operator <=(const std::string& str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator <=( const std::string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2.utf8_compare( str1 ) >= 0;
     }
+    /**
+    *   @fn bool operator >=(const std::string& str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator >=( const std::string& str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2.utf8_compare( str1 ) <= 0;
+    }
+    /**
+    *   @fn bool operator ==(const UTF8basic_string& str1, const char * str2) noexcept
+    *
+    *   Compare a utf-8 string with the bytes of a C-string.
+    *   The C-string is not checked and no utf-8 string is built.
+    *   The other comparison operators with a C-string work the same way.
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 C-string
+    *   @return TRUE if they have the same bytes, FALSE otherwise
+    */
+    friend bool operator ==( const UTF8basic_string& str1, const char * str2 ) noexcept
+    {
+        return str1.utf8_equals_( str2, std::char_traits<char>::length( str2 ) );
+    }
+    /**
+    *   @fn bool operator !=(const UTF8basic_string& str1, const char * str2) noexcept
+    */
+    friend bool operator !=( const UTF8basic_string& str1, const char * str2 ) noexcept
+    {
+        return !( str1 == str2 );
+    }
+    /**
+    *   @fn bool operator <(const UTF8basic_string& str1, const char * str2) noexcept
+    */
+    friend bool operator <( const UTF8basic_string& str1, const char * str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) < 0;
+    }
+    /**
+    *   @fn bool operator >(const UTF8basic_string& str1, const char * str2) noexcept
+    */
+    friend bool operator >( const UTF8basic_string& str1, const char * str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) > 0;
+    }
+    /**
+    *   @fn bool operator <=(const UTF8basic_string& str1, const char * str2) noexcept
+    */
+    friend bool operator <=( const UTF8basic_string& str1, const char * str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) <= 0;
+    }
+    /**
+    *   @fn bool operator >=(const UTF8basic_string& str1, const char * str2) noexcept
+    */
+    friend bool operator >=( const UTF8basic_string& str1, const char * str2 ) noexcept
+    {
+        return str1.utf8_compare( str2 ) >= 0;
+    }
+    /**
+    *   @fn bool operator ==(const char * str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator ==( const char * str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2 == str1;
+    }
+    /**
+    *   @fn bool operator !=(const char * str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator !=( const char * str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return !( str2 == str1 );
+    }
+    /**
+    *   @fn bool operator <(const char * str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator <( const char * str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2.utf8_compare( str1 ) > 0;
+    }
+    /**
+    *   @fn bool operator >(const char * str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator >( const char * str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2.utf8_compare( str1 ) < 0;
+    }
+    /**
+    *   @fn bool operator <=(const char * str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator <=( const char * str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2.utf8_compare( str1 ) >= 0;
+    }
+    /**
+    *   @fn bool operator >=(const char * str1, const UTF8basic_string& str2) noexcept
+    */
+    friend bool operator >=( const char * str1, const UTF8basic_string& str2 ) noexcept
+    {
+        return str2.utf8_compare( str1 ) <= 0;
+    }
+    /**
+    *   @fn UTF8basic_string operator +(const UTF8basic_string& str1, const UTF8basic_string& str2)
+    *
+    *   Generate a string as a concatenation of the two utf-8 givenin arguments
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 utf-8 string
+    *   @return A new string whose values is the concatenation of str1 and str2
+    */
+    friend UTF8basic_string operator +( const UTF8basic_string& str1, const UTF8basic_string& str2 )
+    {
+        return UTF8basic_string( str1 ) + str2;
+    }
+    /**
+    *   @fn UTF8basic_string operator +(UTF8basic_string&& str1, const UTF8basic_string& str2)
+    *
+    *   Append str2 to the temporary str1 and return it,
+    *   the buffer of str1 is reused
+    *
+    *   @param str1 temporary utf-8 string
+    *   @param str2 utf-8 string
+    *   @return A string whose values is the concatenation of str1 and str2
+    */
+    friend UTF8basic_string operator +( UTF8basic_string&& str1, const UTF8basic_string& str2 )
+    {
+        str1 += str2;
+        return std::move( str1 );
+    }
+    /**
+    *   @fn UTF8basic_string operator +(const UTF8basic_string& str1, const std::string& str2)
+    *
+    *   Generate a string as a concatenation of a utf-8 string and a string
+    *   given in arguments
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 string
+    *   @return A new string whose values is the concatenation of str1 and str2
+    */
+    friend UTF8basic_string operator +( const UTF8basic_string& str1, const std::string& str2 )
+    {
+        return UTF8basic_string( str1 ) + str2;
+    }
+    /**
+    *   @fn UTF8basic_string operator +(UTF8basic_string&& str1, const std::string& str2)
+    *
+    *   Append str2 to the temporary str1 and return it,
+    *   the buffer of str1 is reused
+    *
+    *   @param str1 temporary utf-8 string
+    *   @param str2 string
+    *   @return A string whose values is the concatenation of str1 and str2
+    *   @exception std::invalid_argument If str2 is not valid
+    */
+    friend UTF8basic_string operator +( UTF8basic_string&& str1, const std::string& str2 )
+    {
+        str1 += str2;
+        return std::move( str1 );
+    }
+    /**
+    *   @fn UTF8basic_string operator +(const std::string& str1, const UTF8basic_string& str2)
+    *
+    *   Generate a string as a concatenation of a string and a utf-8 string
+    *   given in arguments
+    *
+    *   @param str1 string
+    *   @param str2 utf-8 string
+    *   @return A new string whose values is the concatenation of str1 and str2
+    */
+    friend UTF8basic_string operator +( const std::string& str1, const UTF8basic_string& str2 )
+    {
+        return UTF8basic_string( str1 ) + str2;
+    }
+    /**
+    *   @fn UTF8basic_string operator +(const UTF8basic_string& str1, const char * str2)
+    *
+    *   Generate a string as a concatenation of a utf-8 string and a C-string
+    *   given in arguments
+    *
+    *   @param str1 utf-8 string
+    *   @param str2 C-string
+    *   @return A new string whose values is the concatenation of str1 and str2
+    */
+    friend UTF8basic_string operator +( const UTF8basic_string& str1, const char * str2 )
+    {
+        return UTF8basic_string( str1 ) + str2;
+    }
+    /**
+    *   @fn UTF8basic_string operator +(UTF8basic_string&& str1, const char * str2)
+    *
+    *   Append str2 to the temporary str1 and return it,
+    *   the buffer of str1 is reused
+    *
+    *   @param str1 temporary utf-8 string
+    *   @param str2 C-string
+    *   @return A string whose values is the concatenation of str1 and str2
+    *   @exception std::invalid_argument If str2 is not valid
+    */
+    friend UTF8basic_string operator +( UTF8basic_string&& str1, const char * str2 )
+    {
+        str1 += str2;
+        return std::move( str1 );
+    }
+    /**
+    *   @fn UTF8basic_string operator +(const char * str1, const UTF8basic_string& str2)
+    *
+    *   Generate a string as a concatenation of a C-string and a utf-8 string
+    *   given in arguments
+    *
+    *   @param str1 C-string
+    *   @param str2 utf8 string
+    *   @return A new string whose values is the concatenation of str1 and str2
+    */
+    friend UTF8basic_string operator +( const char * str1, const UTF8basic_string& str2 )
+    {
+        return UTF8basic_string( str1 ) + str2;
+    }
+    /**
+    *   @fn std::ostream& operator <<(std::ostream& os, const UTF8basic_string& str)
+    *
+    *   Insert a utf-8 string into a stream.
+    *
+    *   This function overloads *operator <<* to behave as described
+    *   in *ostream::operator <<* for C-strings, but applied to utf-8 string objects.
+    *
+    *   @param os The output stream
+    *   @param str utf8 string to put
+    *   @return The same as parameter *os*
+    */
+    friend std::ostream& operator <<( std::ostream& os, const UTF8basic_string& str )
+    {
+        os << str._utf8string;
+        return os;
+    }
+    /**
+    *   @fn std::istream& operator >>(std::istream& is, UTF8basic_string& str)
+    *
+    *   Extract a utf-8 string from a stream, storing the sequence in str,
+    *   which is overwritten (the previous value of str is replaced).
+    *
+    *   This function overloads *operator >>* to behave as described
+    *   in *istream::operator >>* for c-strings, but applied to string objects.
+    *
+    *   @param is The input stream
+    *   @param str utf8 string to put
+    *   @return The same as parameter *is*
+    */
+    friend std::istream& operator >>( std::istream& is, UTF8basic_string& str )
+    {
+        std::string tmp;
+        std::getline( is, tmp );
+        str = std::move( tmp );
+        return is;
+    }
+
+    ~UTF8basic_string() = default;
 };
 
-}
 
+template <typename Allocator>
+constexpr size_t UTF8basic_string<Allocator>::npos;
 
 /**
-*   @fn bool operator ==(const UTF8string& str1, const UTF8string& str2) noexcept
-*
-*   Check if two utf-8 strings are equals.
-*
-*   Two utf-8 strings are equals if and only if they heve the same length
-*   and have the same sequence of codepoints.
-*
-*   @param str1 utf-8 string
-*   @param str2 utf-8 string
-*   @return TRUE if they are equals, FALSE otherwise
+*   @typedef UTF8string
+*   @brief UTF-8 string that uses std::allocator
 */
-bool operator ==( const UTF8string& str1, const UTF8string& str2 ) noexcept;
+using UTF8string = UTF8basic_string<>;
 
-/**
-*   @fn bool operator !=(const UTF8string& str1, const UTF8string& str2) noexcept
-*
-*   Check if two utf-8 strings are differents.
-*
-*   @param str1 utf-8 string
-*   @param str2 utf-8 string
-*   @return TRUE if they are not equals, FALSE otherwise
-*/
-bool operator !=( const UTF8string& str1, const UTF8string& str2 ) noexcept;
+extern template class UTF8basic_string<std::allocator<char>>;
 
+#if defined( UTF8_STRING_PMR )
 /**
-*   @fn bool operator <=(const UTF8string& str1, const UTF8string& str2) noexcept
-*
-*   Check if the first utf-8 string is shorter or equal
-*   than/to the second utf-8 string
-*
-*   @param str1 utf-8 string
-*   @param str2 utf-8 string
-*   @return TRUE if the first string is shorter, FALSE otherwise
+*   @typedef UTF8pmr_string
+*   @brief UTF-8 string that uses a std::pmr::memory_resource (C++17, UTF8_STRING_PMR)
 */
-bool operator <=( const UTF8string& str1, const UTF8string& str2 ) noexcept;
+using UTF8pmr_string = UTF8basic_string<std::pmr::polymorphic_allocator<char>>;
 
-/**
-*   @fn bool operator >=(const UTF8string& str1, const UTF8string& str2) noexcept
-*
-*   Check if the first utf-8 string is longer or equal than/to the second utf-8 string
-*
-*   @param str1 utf-8 string
-*   @param str2 utf-8 string
-*   @return TRUE if tthe first string is longer, FALSE otherwise
-*/
-bool operator >=( const UTF8string& str1, const UTF8string& str2 ) noexcept;
+extern template class UTF8basic_string<std::pmr::polymorphic_allocator<char>>;
+#endif
 
-/**
-*   @fn bool operator <(const UTF8string& str1, const UTF8string& str2) noexcept
-*
-*   Check if the first utf-8 string is strictly shorter
-*   than the second utf-8 string
-*
-*   @param str1 utf-8 string
-*   @param str2 utf-8 string
-*   @return TRUE if the first string is strictly shorter, FALSE otherwise
-*/
-bool operator <( const UTF8string& str1, const UTF8string& str2 ) noexcept;
 
 /**
-*   @fn bool operator >(const UTF8string& str1, const UTF8string& str2) noexcept
-*
-*   Check if the first utf-8 string is strictly longer
-*   than the second utf-8 string
+*   @class UTF8basic_result final
+*   @brief Result of UTF8basic_string::try_from()
 *
-*   @param str1 utf-8 string
-*   @param str2 utf-8 string
-*   @return TRUE if the string is strictly longer, FALSE otherwise
+*   It contains either a valid string, or the kind and the position
+*   of the first invalid sequence of the content.
 */
-bool operator >( const UTF8string& str1, const UTF8string& str2 ) noexcept;
+template <typename Allocator>
+class UTF8basic_result final
+{
+    UTF8basic_string<Allocator> _utf8value;
+    UTF8error _utf8error = UTF8error::NONE;
+    size_t _utf8bpos = UTF8basic_string<Allocator>::npos;
 
-/**
-*   @fn UTF8string operator +(const UTF8string& str1, const UTF8string& str2)
-*
-*   Generate a string as a concatenation of the two utf-8 givenin arguments
-*
-*   @param str1 utf-8 string
-*   @param str2 utf-8 string
-*   @return A new string whose values is the concatenation of str1 and str2
-*/
-UTF8string operator +( const UTF8string& str1, const UTF8string& str2 );
+    explicit UTF8basic_result( UTF8basic_string<Allocator>&& value ) noexcept
+        : _utf8value( std::move( value ) ) {}
 
-/**
-*   @fn UTF8string operator +(const UTF8string& str1, const std::string& str2)
-*
-*   Generate a string as a concatenation of a utf-8 string and a string
-*   given in arguments
-*
-*   @param str1 utf-8 string
-*   @param str2 string
-*   @return A new string whose values is the concatenation of str1 and str2
-*/
-UTF8string operator +( const UTF8string& str1, const std::string& str2 );
+    UTF8basic_result( const Allocator& alloc, const UTF8error error, const size_t bpos ) noexcept
+        : _utf8value( alloc ), _utf8error( error ), _utf8bpos( bpos ) {}
 
-/**
-*   @fn UTF8string operator +(const std::string& str1, const UTF8string& str2)
-*
-*   Generate a string as a concatenation of a string and a utf-8 string
-*   given in arguments
-*
-*   @param str1 string
-*   @param str2 utf-8 string
-*   @return A new string whose values is the concatenation of str1 and str2
-*/
-UTF8string operator +( const std::string& str1, const UTF8string& str2 );
+    friend class UTF8basic_string<Allocator>;
 
-/**
-*   @fn UTF8string operator +(const UTF8string& str1, const char * str2)
-*
-*   Generate a string as a concatenation of a utf-8 string and a C-string
-*   given in arguments
-*
-*   @param str1 utf-8 string
-*   @param str2 C-string
-*   @return A new string whose values is the concatenation of str1 and str2
-*/
-UTF8string operator +( const UTF8string& str1, const char * str2 );
+public:
 
-/**
-*   @fn UTF8string operator +(const char * str1, const UTF8string& str2)
-*
-*   Generate a string as a concatenation of a C-string and a utf-8 string
-*   given in arguments
-*
-*   @param str1 C-string
-*   @param str2 utf8 string
-*   @return A new string whose values is the concatenation of str1 and str2
-*/
-UTF8string operator +( const char * str1, const UTF8string& str2 );
+    /**
+    *   @fn explicit operator bool() const noexcept
+    *   @return TRUE if the content was valid, FALSE otherwise
+    */
+    explicit operator bool() const noexcept
+    {
+        return _utf8error == UTF8error::NONE;
+    }
+    /**
+    *   @fn UTF8error utf8_error() const noexcept
+    *   @return The kind of the first invalid sequence, UTF8error::NONE if the content was valid
+    */
+    UTF8error utf8_error() const noexcept
+    {
+        return _utf8error;
+    }
+    /**
+    *   @fn size_t utf8_error_bpos() const noexcept
+    *   @return The position (in bytes) of the first invalid sequence in the content,
+    *           *npos* if the content was valid
+    */
+    size_t utf8_error_bpos() const noexcept
+    {
+        return _utf8bpos;
+    }
+    /**
+    *   @fn const UTF8basic_string<Allocator>& utf8_value() const &
+    *   @return The string
+    *   @exception std::invalid_argument If the content was not valid
+    */
+    const UTF8basic_string<Allocator>& utf8_value() const &
+    {
+        if ( _utf8error != UTF8error::NONE )
+            throw std::invalid_argument( "Invalid UTF-8 string\n" );
+
+        return _utf8value;
+    }
+    /**
+    *   @fn UTF8basic_string<Allocator> utf8_value() &&
+    *   @return The string, it is moved out of the result
+    *   @exception std::invalid_argument If the content was not valid
+    */
+    UTF8basic_string<Allocator> utf8_value() &&
+    {
+        if ( _utf8error != UTF8error::NONE )
+            throw std::invalid_argument( "Invalid UTF-8 string\n" );
+
+        return std::move( _utf8value );
+    }
+};
 
 /**
-*   @fn std::ostream& operator <<(std::ostream& os, const UTF8string& str)
-*
-*   Insert a utf-8 string into a stream.
-*
-*   This function overloads *operator <<* to behave as described
-*   in *ostream::operator <<* for C-strings, but applied to utf-8 string objects.
-*
-*   @param os The output stream
-*   @param str utf8 string to put
-*   @return The same as parameter *os*
+*   @typedef UTF8result
+*   @brief Result of UTF8string::try_from()
 */
-std::ostream& operator <<( std::ostream& os, const UTF8string& str );
+using UTF8result = UTF8basic_result<>;
 
-/**
-*   @fn std::istream& operator >>(std::istream& is, UTF8string& str)
-*
-*   Extract a utf-8 string from a stream, storing the sequence in str,
-*   which is overwritten (the previous value of str is replaced).
-*
-*   This function overloads *operator >>* to behave as described
-*   in *istream::operator >>* for c-strings, but applied to string objects.
-*
-*   @param is The input stream
-*   @param str utf8 string to put
-*   @return The same as parameter *is*
+
+namespace std
+{
+
+template <typename Allocator>
+class hash<UTF8basic_string<Allocator>>
+{
+public:
+    size_t operator()( const UTF8basic_string<Allocator>& u8str ) const
+    {
+        return u8str.hash();
+    }
+};
+
+}
+
+
+/*
+    The kept codepoints are moved towards the beginning of the buffer
+    (r: read position, w: write position), then the buffer is truncated
 */
-std::istream& operator >>( std::istream& is, UTF8string& str );
+template <typename Allocator>
+template <typename Predicate>
+size_t UTF8basic_string<Allocator>::utf8_erase_if( Predicate pred )
+{
+    const size_t U8SIZE = _utf8string.size();
+    size_t removed = 0;
+    size_t w = 0;
+    size_t r = 0;
+
+    try
+    {
+        while ( r < U8SIZE )
+        {
+            const size_t N = utf8_codepoint_len_( r );
+
+            if ( pred( UTF8char( _utf8string.data() + r, N ) ) )
+                removed += 1;
+            else
+            {
+                if ( w != r )
+                    std::char_traits<char>::move( &_utf8string[w], &_utf8string[r], N );
+
+                w += N;
+            }
+
+            r += N;
+        }
+    }
+    catch ( ... )
+    {
+        // The rest of the string is kept
+        _utf8string.erase( w, r - w );
+        _utf8length -= removed;
+        utf8_invalidate_();
+        throw;
+    }
+
+    if ( removed > 0 )
+    {
+        _utf8string.resize( w );
+        _utf8length -= removed;
+        utf8_invalidate_();
+    }
+
+    return removed;
+}
 
 #include "utf8_iterator.hpp"
+#include "utf8_string_view.hpp"
 
 #endif // UTF8_STRING_HPP_INCLUDED
@@ -0,0 +1,201 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#include "utf8_string.hpp"
+#include "utf8_kernel.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+
+UTF8string_view::UTF8string_view( const char * data, const size_t size,
+                                  const size_t length ) noexcept
+    : _utf8data( data ), _utf8size( size ), _utf8length( length ) {}
+
+UTF8string_view::UTF8string_view( const char * data, const size_t size )
+    : _utf8data( data ), _utf8size( size ), _utf8length( utf8_kernel::length( data, size ) )
+{
+    if ( _utf8length == utf8_kernel::npos )
+        throw std::invalid_argument( "Invalid UTF-8 string\n" );
+}
+
+
+bool UTF8string_view::utf8_empty() const noexcept
+{
+    return _utf8length == 0;
+}
+
+
+// Get the memory position of a codepoint in the view (no index, linear)
+size_t UTF8string_view::utf8_bpos_at_( const size_t cpos ) const noexcept
+{
+    if ( utf8_is_ascii() )
+        return cpos < _utf8size ? cpos : _utf8size;
+
+    return utf8_kernel::advance( _utf8data, _utf8size, 0U, cpos );
+}
+
+
+UTF8string_view::u8char UTF8string_view::utf8_at( const size_t index ) const
+{
+    if ( index >= _utf8length )
+        throw std::out_of_range( "index value greater than the size of the string" );
+
+    return ( *this )[index];
+}
+
+
+UTF8string_view::u8char UTF8string_view::operator []( const size_t index ) const noexcept
+{
+    const size_t BPOS = utf8_bpos_at_( index );
+    const size_t NEXT = utf8_is_ascii() ? BPOS + 1 : utf8_kernel::advance( _utf8data, _utf8size, BPOS, 1U );
+    return UTF8char( _utf8data + BPOS, NEXT - BPOS );
+}
+
+
+UTF8string_view UTF8string_view::utf8_substr( size_t pos, size_t len ) const noexcept
+{
+    if ( pos > _utf8length )
+        return UTF8string_view();
+
+    const size_t N = ( len == npos || ( pos + len ) > _utf8length ) ?
+                     ( _utf8length - pos ) : len;
+
+    const size_t BFIRST = utf8_bpos_at_( pos );
+    const size_t BLAST  = utf8_is_ascii() ? BFIRST + N : utf8_kernel::advance( _utf8data, _utf8size, BFIRST, N );
+    return UTF8string_view( _utf8data + BFIRST, BLAST - BFIRST, N );
+}
+
+
+size_t UTF8string_view::utf8_find( const UTF8string_view& str, size_t pos ) const noexcept
+{
+    if ( str._utf8length == 0 || pos > _utf8length )
+        return npos;
+
+    // UTF-8 is self-synchronizing, a byte match is a codepoint match
+    const size_t BPOS  = utf8_bpos_at_( pos );
+    const size_t FOUND = utf8_kernel::find( _utf8data + BPOS, _utf8size - BPOS,
+                                            str._utf8data, str._utf8size );
+
+    if ( FOUND == utf8_kernel::npos )
+        return npos;
+
+    return pos + ( utf8_is_ascii() ? FOUND : utf8_kernel::count( _utf8data + BPOS, FOUND ) );
+}
+
+
+size_t UTF8string_view::utf8_size() const noexcept
+{
+    return _utf8size;
+}
+
+size_t UTF8string_view::utf8_length() const noexcept
+{
+    return _utf8length;
+}
+
+bool UTF8string_view::utf8_is_ascii() const noexcept
+{
+    return _utf8length == _utf8size;
+}
+
+const char * UTF8string_view::utf8_data() const noexcept
+{
+    return _utf8data;
+}
+
+std::string UTF8string_view::utf8_sstring() const
+{
+    return std::string( _utf8data, _utf8size );
+}
+
+size_t UTF8string_view::hash() const noexcept
+{
+    return utf8_kernel::hash( _utf8data, _utf8size );
+}
+
+
+UTF8iterator UTF8string_view::utf8_begin() const noexcept
+{
+    return UTF8iterator( _utf8data, _utf8size, 0U, 0U );
+}
+
+UTF8iterator UTF8string_view::utf8_end() const noexcept
+{
+    return UTF8iterator( _utf8data, _utf8size, _utf8size, _utf8length );
+}
+
+UTF8iterator UTF8string_view::begin() const noexcept
+{
+    return utf8_begin();
+}
+
+UTF8iterator UTF8string_view::end() const noexcept
+{
+    return utf8_end();
+}
+
+
+namespace
+{
+
+int compare( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept
+{
+    const size_t N = std::min( v1.utf8_size(), v2.utf8_size() );
+    const int CMP = N == 0 ? 0 : std::memcmp( v1.utf8_data(), v2.utf8_data(), N );
+
+    if ( CMP != 0 )
+        return CMP;
+
+    return v1.utf8_size() < v2.utf8_size() ? -1 : ( v1.utf8_size() > v2.utf8_size() ? 1 : 0 );
+}
+
+}
+
+
+bool operator ==( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept
+{
+    return v1.utf8_size() == v2.utf8_size() && compare( v1, v2 ) == 0;
+}
+
+bool operator !=( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept
+{
+    return !( v1 == v2 );
+}
+
+bool operator <( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept
+{
+    return compare( v1, v2 ) < 0;
+}
+
+bool operator >( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept
+{
+    return compare( v1, v2 ) > 0;
+}
+
+bool operator <=( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept
+{
+    return compare( v1, v2 ) <= 0;
+}
+
+bool operator >=( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept
+{
+    return compare( v1, v2 ) >= 0;
+}
+
+
+std::ostream& operator <<( std::ostream& os, const UTF8string_view& v )
+{
+    os.write( v.utf8_data(), static_cast<std::streamsize>( v.utf8_size() ) );
+    return os;
+}
@@ -0,0 +1,268 @@
+/*
+*
+*   Copyright © 2018 Luxon Jean-Pierre
+*   https://gumichan01.github.io/
+*
+*   This library is under the MIT license
+*
+*   Luxon Jean-Pierre (Gumichan01)
+*   luxon.jean.pierre@gmail.com
+*
+*/
+
+#ifndef UTF8_STRING_VIEW_HPP_INCLUDED
+#define UTF8_STRING_VIEW_HPP_INCLUDED
+
+/**
+*   @file utf8_string_view.hpp
+*   @brief This is a UTF-8 string library header
+*/
+
+#include "utf8_char.hpp"
+
+#include <string>
+#include <iostream>
+
+template <typename Allocator> class UTF8basic_string;
+class UTF8iterator;
+
+/**
+*   @class UTF8string_view final
+*   @brief Non-owning view of a UTF-8 string
+*
+*   This class defines a read-only view of a valid UTF-8 sequence.
+*   It does not own the data, the viewed string must outlive the view.
+*   Any modification of the viewed string invalidates the view.
+*/
+class UTF8string_view final
+{
+    const char * _utf8data = nullptr;
+    size_t _utf8size = 0U;
+    size_t _utf8length = 0U;
+
+    UTF8string_view( const char * data, const size_t size, const size_t length ) noexcept;
+    size_t utf8_bpos_at_( const size_t cpos ) const noexcept;
+
+    template <typename> friend class UTF8basic_string;
+    friend class UTF8records;
+    friend class UTF8interner;
+
+public:
+
+    /**
+    *   @typedef u8char
+    *   @brief The UTF-8 character
+    */
+    using u8char = UTF8char;
+
+    /**
+    *   @var npos
+    *   @brief Same as UTF8string::npos
+    */
+    constexpr static size_t npos = std::string::npos;
+
+    /**
+    *   @fn UTF8string_view() noexcept
+    *   Build an empty view
+    */
+    UTF8string_view() noexcept = default;
+    /**
+    *   @fn template <typename Allocator> UTF8string_view(const UTF8basic_string<Allocator>& u8str) noexcept
+    *   Build a view of the whole utf-8 string
+    *   @param u8str The utf-8 string
+    *   @note A view of a temporary string is only valid until the end of
+    *         the full expression, it must not be stored
+    */
+    template <typename Allocator>
+    UTF8string_view( const UTF8basic_string<Allocator>& u8str ) noexcept
+        : _utf8data( u8str.utf8_str() ), _utf8size( u8str.utf8_size() ),
+          _utf8length( u8str.utf8_length() ) {}
+    /**
+    *   @fn UTF8string_view(const char * data, const size_t size)
+    *
+    *   Build a view of a buffer. The buffer is checked.
+    *
+    *   @param data The buffer
+    *   @param size The size of the buffer (in bytes)
+    *   @exception std::invalid_argument If the buffer is not valid
+    */
+    UTF8string_view( const char * data, const size_t size );
+    /**
+    *   @fn UTF8string_view(const UTF8string_view& v) noexcept
+    *   @param v The view to copy
+    */
+    UTF8string_view( const UTF8string_view& v ) noexcept = default;
+    /**
+    *   @fn UTF8string_view& operator =(const UTF8string_view& v) noexcept
+    *   @param v The view to copy
+    *   @return A reference to the view
+    */
+    UTF8string_view& operator =( const UTF8string_view& v ) noexcept = default;
+
+    /**
+    *   @fn bool utf8_empty() const noexcept
+    *   @return TRUE If the view is empty, FALSE otherwise
+    */
+    bool utf8_empty() const noexcept;
+
+    /**
+    *   @fn UTF8string_view::u8char utf8_at(const size_t index) const
+    *
+    *   Get the codepoint at a specified position.
+    *
+    *   @param index The index of the requested codepoint in the view
+    *   @return The codepoint
+    *   @exception std::out_of_range If the index is out of the view range
+    */
+    u8char utf8_at( const size_t index ) const;
+    /**
+    *   @fn UTF8string_view::u8char operator [](const size_t index) const noexcept
+    *
+    *   Get the codepoint at a specified position.
+    *
+    *   @param index The index of the requested codepoint in the view
+    *   @return The codepoint
+    *   @note If the index is out of the view range, calling this functions
+    *         causes undefined behaviour
+    */
+    u8char operator []( const size_t index ) const noexcept;
+
+    /**
+    *   @fn UTF8string_view utf8_substr(size_t pos = 0, size_t len = npos) const noexcept
+    *
+    *   Get a view of a part of the current view.
+    *
+    *   @param pos The beginning position of the substring (default value: 0)
+    *   @param len The length of the substring (in number of codepoints, default value = npos)
+    *   @return The view of the substring, nothing is copied
+    */
+    UTF8string_view utf8_substr( size_t pos = 0, size_t len = npos ) const noexcept;
+    /**
+    *   @fn size_t utf8_find(const UTF8string_view& str, size_t pos = 0) const noexcept
+    *
+    *   Search for the first occurrence of utf8 string
+    *   specified in argument, from the position pos.
+    *
+    *   @param str The string to look for
+    *   @param pos The position to start the search
+    *   @return The position of the substring if it was found
+    *           (in number of codepoints), UTF8string_view::npos otherwise.
+    */
+    size_t utf8_find( const UTF8string_view& str, size_t pos = 0 ) const noexcept;
+
+    /**
+    *   @fn size_t utf8_size() const noexcept
+    *   @return The memory size (in bytes) of the view
+    */
+    size_t utf8_size() const noexcept;
+    /**
+    *   @fn size_t utf8_length() const noexcept
+    *   @return The length of the view (in number of codepoints)
+    */
+    size_t utf8_length() const noexcept;
+    /**
+    *   @fn bool utf8_is_ascii() const noexcept
+    *   @return TRUE if every codepoint of the view is a 7-bit ASCII character,
+    *           FALSE otherwise (constant time)
+    */
+    bool utf8_is_ascii() const noexcept;
+    /**
+    *   @fn const char * utf8_data() const noexcept
+    *   @return A pointer to the first byte of the view
+    *   @note The sequence is not null-terminated
+    */
+    const char * utf8_data() const noexcept;
+    /**
+    *   @fn std::string utf8_sstring() const
+    *   @return A copy of the content of the view
+    */
+    std::string utf8_sstring() const;
+    /**
+    *   @fn size_t hash() const noexcept
+    *   Generate a hash value of the view
+    *   @return The hash value, the same as the one of a UTF8string
+    *           with the same content
+    */
+    size_t hash() const noexcept;
+
+    /**
+    *   @fn UTF8iterator utf8_begin() const noexcept
+    *   @return An iterator to the beginning of the view
+    */
+    UTF8iterator utf8_begin() const noexcept;
+    /**
+    *   @fn UTF8iterator utf8_end() const noexcept
+    *   @return An iterator to the past-the-end codepoint of the view
+    */
+    UTF8iterator utf8_end() const noexcept;
+    /**
+    *   @fn UTF8iterator begin() const noexcept
+    *   @note Same as utf8_begin()
+    */
+    UTF8iterator begin() const noexcept;
+    /**
+    *   @fn UTF8iterator end() const noexcept
+    *   @note Same as utf8_end()
+    */
+    UTF8iterator end() const noexcept;
+
+    ~UTF8string_view() = default;
+};
+
+
+namespace std
+{
+
+template<>
+class hash<UTF8string_view>
+{
+public:
+    size_t operator()( const UTF8string_view& v ) const noexcept
+    {
+        return v.hash();
+    }
+};
+
+}
+
+
+/**
+*   @fn bool operator ==(const UTF8string_view& v1, const UTF8string_view& v2) noexcept
+*   @param v1 utf-8 view
+*   @param v2 utf-8 view
+*   @return TRUE if the views have the same content, FALSE otherwise
+*/
+bool operator ==( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept;
+/**
+*   @fn bool operator !=(const UTF8string_view& v1, const UTF8string_view& v2) noexcept
+*/
+bool operator !=( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept;
+/**
+*   @fn bool operator <(const UTF8string_view& v1, const UTF8string_view& v2) noexcept
+*   @return TRUE if the content of v1 is before the content of v2
+*           (lexicographical order), FALSE otherwise
+*/
+bool operator <( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept;
+/**
+*   @fn bool operator >(const UTF8string_view& v1, const UTF8string_view& v2) noexcept
+*/
+bool operator >( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept;
+/**
+*   @fn bool operator <=(const UTF8string_view& v1, const UTF8string_view& v2) noexcept
+*/
+bool operator <=( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept;
+/**
+*   @fn bool operator >=(const UTF8string_view& v1, const UTF8string_view& v2) noexcept
+*/
+bool operator >=( const UTF8string_view& v1, const UTF8string_view& v2 ) noexcept;
+
+/**
+*   @fn std::ostream& operator <<(std::ostream& os, const UTF8string_view& v)
+*   Insert the content of a view into a stream.
+*   @param os The output stream
+*   @param v The view
+*   @return The same as parameter *os*
+*/
+std::ostream& operator <<( std::ostream& os, const UTF8string_view& v );
+
+#endif // UTF8_STRING_VIEW_HPP_INCLUDED
@@ -16,8 +16,17 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <type_traits>
 
 #include "../src/utf8_string.hpp"
+#include "../src/utf8_searcher.hpp"
+#include "../src/utf8_automaton.hpp"
+#include "../src/utf8_builder.hpp"
+#include "../src/utf8_records.hpp"
+#include "../src/utf8_interner.hpp"
 
 using namespace std;
 
@@ -169,6 +178,22 @@ int main()
 
             if ( !hw.utf8_empty() )
                 return 182;
+
+            // The string is not modified if the new content is invalid
+            try
+            {
+                u8cstr.utf8_assign( std::string( "がんば\xFF" ) );
+                return 183;
+            }
+            catch ( const std::invalid_argument& ) {}
+
+            if ( u8cstr.utf8_sstring() != std::string( hello ) || u8cstr.utf8_length() != 5 )
+                return 186;
+
+            u8strp.utf8_assign( std::string( "がんばつて" ), 3U, 6U );
+
+            if ( u8strp != UTF8string( "んば" ) || u8strp.utf8_length() != 2 )
+                return 187;
         }
     }
 
@@ -522,6 +547,44 @@ int main()
         }
         catch ( const std::invalid_argument& ) {}
 
+        try
+        {
+            // Overlong encoding of '/' (0xC0 0xAF)
+            char inv39[] = {'\xC0', '\xAF', '\x00'};
+            string chstr = inv39;
+            UTF8string u8 = chstr;
+
+            return 39;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        // Long strings: the invalid byte can be anywhere in the buffer
+        {
+            const std::string VALID = jap1 + "Gumichan " + jap2;
+
+            try
+            {
+                UTF8string u8 = VALID;
+            }
+            catch ( const std::invalid_argument& )
+            {
+                return 184;
+            }
+
+            for ( size_t i = 0; i < VALID.size(); ++i )
+            {
+                std::string s = VALID;
+                s[i] = '\xFF';
+
+                try
+                {
+                    UTF8string u8 = s;
+                    return 185;
+                }
+                catch ( const std::invalid_argument& ) {}
+            }
+        }
+
 
         try
         {
@@ -617,6 +680,30 @@ int main()
 
         if ( strex1 != strex2 )
             return 56;
+
+        // Invalid fragment
+        try
+        {
+            strex1 += "\xE3\x81";
+            return 200;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        try
+        {
+            strex1 += std::string( "\x81\x82" );
+            return 201;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        if ( strex1 != strex2 || strex1.utf8_length() != 15 )
+            return 202;
+
+        // Self-append
+        gumi += gumi;
+
+        if ( gumi.utf8_length() != 28 || gumi != UTF8string( "Gumichan がんばつてGumichan がんばつて" ) )
+            return 203;
     }
 
     // Get the codepoint at a specified position
@@ -852,6 +939,893 @@ int main()
         std::cout << "hash heLlo : " << std::hash<decltype( hellom )>()( hellom ) << "\n";
     }
 
+    // Random access in a large string
+    {
+        const std::string CPOINTS[] = {"a", "é", "が", "😀"};
+        std::vector<std::string> expected;
+        UTF8string u8;
+
+        for ( size_t i = 0; i < 3000; ++i )
+        {
+            expected.push_back( CPOINTS[( i * 7 + i / 5 ) % 4] );
+            u8 += expected.back();
+        }
+
+        for ( size_t i = 0; i < expected.size(); i += 3 )
+        {
+            if ( u8.utf8_at( i ) != expected[i] )
+                return 210;
+        }
+
+        // Remove and append codepoints at the end
+        for ( size_t i = 0; i < 300; ++i )
+        {
+            u8.utf8_pop();
+            expected.pop_back();
+        }
+
+        if ( u8[expected.size() - 1] != expected.back() )
+            return 211;
+
+        for ( size_t i = 0; i < 600; ++i )
+        {
+            expected.push_back( CPOINTS[i % 4] );
+            u8 += expected.back();
+        }
+
+        for ( size_t i = 0; i < expected.size(); i += 5 )
+        {
+            if ( u8[i] != expected[i] )
+                return 212;
+        }
+
+        // Any other modification drops the index
+        u8.utf8_erase( 0, 1 );
+        expected.erase( expected.begin() );
+
+        for ( size_t i = 0; i < expected.size(); i += 5 )
+        {
+            if ( u8[i] != expected[i] )
+                return 213;
+        }
+    }
+
+    // Iterators
+    {
+        const UTF8string u8( "がんばつて Gumichan" );
+        std::string concat;
+        size_t n = 0;
+
+        for ( const UTF8string::u8char& c : u8 )
+        {
+            concat += c;
+            n += 1;
+        }
+
+        if ( concat != u8.utf8_sstring() || n != u8.utf8_length() )
+            return 220;
+
+        if ( std::distance( u8.utf8_begin(), u8.utf8_end() ) != 14 )
+            return 221;
+
+        if ( std::count( u8.begin(), u8.end(), UTF8string::u8char( "a" ) ) != 1 )
+            return 222;
+
+        auto it = std::find( u8.begin(), u8.end(), UTF8string::u8char( "G" ) );
+
+        if ( it - u8.begin() != 6 || *( it-- ) != "G" || *it != " " )
+            return 223;
+
+        std::string rev;
+
+        for ( auto rit = u8.end(); rit != u8.begin(); )
+        {
+            rev += *( --rit );
+        }
+
+        if ( rev != "nahcimuG てつばんが" )
+            return 224;
+
+        if ( ( u8.utf8_end() - 2 ) - ( u8.utf8_begin() + 3 ) != 9 )
+            return 225;
+
+        try
+        {
+            *u8.utf8_end();
+            return 226;
+        }
+        catch ( const std::out_of_range& ) {}
+    }
+
+    // Iterator traits
+    {
+        using Traits = std::iterator_traits<UTF8iterator>;
+        static_assert( std::is_same<Traits::difference_type, std::ptrdiff_t>::value,
+                       "iterator difference" );
+        static_assert( std::is_same<Traits::iterator_category, std::input_iterator_tag>::value,
+                       "iterator category" );
+
+        const UTF8string u8( "がんばつて" );
+        UTF8iterator it;
+        it = u8.utf8_begin() + 2;
+
+        if ( *it != "ば" || std::distance( it, u8.utf8_end() ) != 3 )
+            return 139;
+    }
+
+    // Codepoints
+    {
+        const UTF8string u8( "aéが😀" );
+        const char32_t CODEPOINTS[] = {U'a', U'é', U'が', U'😀'};
+        std::unordered_map<UTF8string::u8char, size_t> counter;
+
+        for ( size_t i = 0; i < u8.utf8_length(); ++i )
+        {
+            const UTF8string::u8char c = u8[i];
+
+            if ( c.utf8_codepoint() != CODEPOINTS[i] || c != UTF8char( CODEPOINTS[i] ) )
+                return 230;
+
+            if ( c.utf8_size() != i + 1 || std::string( c ) != u8.utf8_sstring().substr( i * ( i + 1 ) / 2, i + 1 ) )
+                return 231;
+
+            counter[c] += 1;
+            counter[UTF8char( CODEPOINTS[i] )] += 1;
+        }
+
+        if ( counter.size() != 4 || counter[UTF8char( U'が' )] != 2 )
+            return 232;
+
+        if ( !( u8[0] < u8[1] && u8[1] < u8[2] && u8[2] < u8[3] ) )
+            return 233;
+
+        const UTF8char nul( U'\0' );
+        const UTF8char empty;
+
+        if ( nul.utf8_size() != 1 || nul == empty || nul == "" || !( empty < nul ) || nul < empty
+             || !( nul < UTF8char( U'a' ) ) )
+            return 148;
+
+        try
+        {
+            UTF8char surrogate( char32_t( 0xD800 ) );
+            return 234;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        try
+        {
+            UTF8char two( std::string( "ab" ) );
+            return 235;
+        }
+        catch ( const std::invalid_argument& ) {}
+    }
+
+    // Views
+    {
+        const UTF8string u8( "がんばつて Gumichan; がんばつて 01" );
+        const UTF8string_view v( u8 );
+        static_assert( std::is_nothrow_move_assignable<UTF8string>::value, "UTF8string move" );
+
+        const UTF8string semicolon( ";" );
+        const UTF8string_view sep( semicolon );
+        const size_t POS = v.utf8_find( sep );
+
+        if ( POS != 14 || v.utf8_length() != u8.utf8_length() || v.hash() != u8.hash() )
+            return 240;
+
+        const UTF8string_view first  = v.utf8_substr( 0, POS );
+        const UTF8string_view second = v.utf8_substr( POS + 2 );
+
+        if ( first != UTF8string( "がんばつて Gumichan" ) || first.utf8_length() != 14 )
+            return 241;
+
+        if ( UTF8string( second ) != UTF8string( "がんばつて 01" ) || second.utf8_size() != 18 )
+            return 242;
+
+        // A view of a view still points into the original string
+        const UTF8string_view gumi = first.utf8_substr( 6, 4 );
+
+        if ( gumi.utf8_data() != u8.utf8_str() + 16 || gumi != UTF8string( "Gumi" ) )
+            return 243;
+
+        if ( second.utf8_at( 3 ) != "つ" || first[6] != "G" || second.utf8_find( UTF8string( "01" ) ) != 6 )
+            return 244;
+
+        if ( first.utf8_find( UTF8string( "がんばつて" ), 1 ) != UTF8string_view::npos )
+            return 245;
+
+        std::string concat;
+
+        for ( const UTF8char& c : second )
+        {
+            concat += c;
+        }
+
+        if ( concat != second.utf8_sstring() || !( second < first ) || u8 != v )
+            return 246;
+
+        try
+        {
+            UTF8string_view invalid( "\xE3\x81", 2 );
+            return 247;
+        }
+        catch ( const std::invalid_argument& ) {}
+    }
+
+    // Moves do not copy the content
+    {
+        std::string raw( 64, 'a' );
+        raw += "がんばつて";
+        const char * const BUFFER = raw.data();
+
+        UTF8string u8( std::move( raw ) );
+
+        if ( u8.utf8_str() != BUFFER || u8.utf8_length() != 69 )
+            return 110;
+
+        UTF8string moved( std::move( u8 ) );
+
+        if ( moved.utf8_str() != BUFFER || !u8.utf8_empty() || u8.utf8_size() != 0 )
+            return 111;
+
+        u8 = std::move( moved );
+
+        if ( u8.utf8_str() != BUFFER || !moved.utf8_empty() || u8[65] != "ん" )
+            return 112;
+
+        // The temporary on the left is reused
+        const UTF8string u8cat = std::move( u8 ) + UTF8string( " Gumi" ) + "chan" + std::string( " 01" );
+
+        if ( u8cat.utf8_length() != 81 || u8cat.utf8_substr( 70 ) != UTF8string( "Gumichan 01" ) )
+            return 113;
+
+        UTF8string tmp( u8cat );
+        const std::string out = std::move( tmp ).utf8_sstring();
+
+        if ( out != u8cat.utf8_sstring() || !tmp.utf8_empty() )
+            return 114;
+
+        std::string invalid( "\xC0\xAF" );
+
+        try
+        {
+            tmp = std::move( invalid );
+            return 115;
+        }
+        catch ( const std::invalid_argument& )
+        {
+            if ( invalid.size() != 2 || !tmp.utf8_empty() )
+                return 116;
+        }
+    }
+
+    // Byte search, the needle may cross the SIMD blocks
+    {
+        UTF8string hay;
+
+        for ( int i = 0; i < 40; ++i )
+        {
+            hay += "がんばつて Gumichan ";
+        }
+
+        hay += "がんばる";
+        const UTF8string ganba( "がんばる" );
+
+        if ( hay.utf8_find( ganba ) != 600 || hay.utf8_find( ganba, 601 ) != UTF8string::npos )
+            return 120;
+
+        if ( hay.utf8_find( UTF8string( "Gumichan" ), 7 ) != 21 || hay.utf8_find( UTF8string( "て G" ), 500 ) != 514 )
+            return 121;
+
+        // Same result as a codepoint by codepoint search
+        const UTF8string needle( "ん" );
+
+        for ( size_t pos = 0; pos <= hay.utf8_length(); pos += 7 )
+        {
+            size_t expected = UTF8string::npos;
+
+            for ( size_t j = pos; j < hay.utf8_length(); ++j )
+            {
+                if ( hay[j] == needle[0] )
+                {
+                    expected = j;
+                    break;
+                }
+            }
+
+            if ( hay.utf8_find( needle, pos ) != expected )
+                return 122;
+        }
+
+        if ( ganba.utf8_find( hay ) != UTF8string::npos || hay.utf8_find( ganba, 605 ) != UTF8string::npos )
+            return 123;
+    }
+
+    // One pattern, several strings
+    {
+        const UTF8string NEEDLES[] = { "がんばつて", "Gumichan", "aaab", "て G", "01" };
+        const UTF8string HAYSTACKS[] = { "がんばつて Gumichan", "Gumichan; がんばつて 01 aaaab",
+                                         "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", "" };
+
+        for ( const UTF8string& needle : NEEDLES )
+        {
+            const UTF8searcher searcher( needle );
+
+            for ( const UTF8string& hay : HAYSTACKS )
+            {
+                for ( size_t pos = 0; pos <= hay.utf8_length() + 1; ++pos )
+                {
+                    if ( searcher.utf8_find( hay, pos ) != hay.utf8_find( needle, pos )
+                            || searcher.utf8_find( UTF8string_view( hay ), pos ) != hay.utf8_find( needle, pos ) )
+                        return 130;
+                }
+            }
+        }
+
+        const UTF8string hay( "Gumichan; がんばつて 01 aaaab" );
+        const UTF8searcher searcher( UTF8string( "つて" ) );
+        const std::pair<UTF8iterator, UTF8iterator> r = searcher( hay.utf8_begin() + 1, hay.utf8_end() );
+
+        if ( r.first - hay.utf8_begin() != 13 || r.second - r.first != 2 || *r.second != " " )
+            return 131;
+
+        const std::pair<UTF8iterator, UTF8iterator> none = searcher( hay.utf8_begin() + 14, hay.utf8_end() );
+
+        if ( none.first != hay.utf8_end() || none.second != hay.utf8_end() )
+            return 132;
+    }
+
+    // Several patterns in one pass
+    {
+        const std::vector<UTF8string> patterns = { "がんばつて", "ばつ", "Gumi", "chan", "", "つて G", "ばつ" };
+        const UTF8automaton automaton( patterns );
+        const UTF8string hay( "がんばつて Gumichan; がんばる" );
+        const std::vector<UTF8automaton::match> matches = automaton.utf8_find_all( hay );
+        const std::vector<UTF8automaton::match> expected = { {1, 2}, {6, 2}, {0, 0}, {5, 3}, {2, 6}, {3, 10} };
+
+        if ( matches != expected )
+            return 140;
+
+        // Same positions as utf8_find
+        for ( const UTF8automaton::match& m : matches )
+        {
+            if ( hay.utf8_substr( m.second, patterns[m.first].utf8_length() ) != patterns[m.first] )
+                return 141;
+        }
+
+        size_t n = 0;
+        automaton.utf8_scan( UTF8string_view( hay ).utf8_substr( 6 ), [&n]( size_t, size_t )
+        {
+            n += 1;
+        } );
+
+        if ( n != 2 || !UTF8automaton( {} ).utf8_find_all( hay ).empty() )
+            return 142;
+    }
+
+    // All the occurrences, the last one
+    {
+        const UTF8string hay( "がんばつて Gumichan; がんばつて 01; ががが" );
+        const UTF8string ganba( "がんばつて" );
+        const std::vector<size_t> all = hay.utf8_find_all( ganba );
+
+        if ( all != std::vector<size_t>( { 0, 16 } ) || hay.utf8_find_all( ganba, 1 ) != std::vector<size_t>( { 16 } ) )
+            return 150;
+
+        if ( hay.utf8_count( UTF8string( "がが" ) ) != 1 || hay.utf8_find_all( UTF8string( "が" ) ).size() != 5 )
+            return 151;
+
+        if ( hay.utf8_rfind( ganba ) != 16 || hay.utf8_rfind( ganba, 15 ) != 0 || hay.utf8_rfind( ganba, 16 ) != 16 )
+            return 152;
+
+        if ( hay.utf8_rfind( UTF8string( "が" ) ) != 28 || hay.utf8_rfind( UTF8string( "01" ), 10 ) != UTF8string::npos )
+            return 153;
+
+        if ( hay.utf8_count( UTF8string() ) != 0 || UTF8string( "ab" ).utf8_rfind( UTF8string( "abc" ) ) != UTF8string::npos )
+            return 154;
+
+        // The last codepoints are shorter than the ones of the pattern
+        const UTF8string tail( "がんばつてabcdef" );
+
+        if ( tail.utf8_rfind( UTF8string( "がんばつて" ) ) != 0 || tail.utf8_rfind( UTF8string( "てa" ) ) != 4
+                || tail.utf8_rfind( UTF8string( "てf" ) ) != UTF8string::npos )
+            return 155;
+    }
+
+    // Reverse a large string in place
+    {
+        UTF8string u8;
+
+        for ( size_t i = 0; i < 100000; ++i )
+        {
+            u8 += "aéが😀";
+        }
+
+        const UTF8string orig( u8 );
+        const char * const BUFFER = u8.utf8_str();
+        u8.utf8_reverse();
+
+        if ( u8.utf8_str() != BUFFER || u8.utf8_length() != 400000 || u8[0] != "😀" || u8[399998] != "é" )
+            return 160;
+
+        if ( u8.utf8_reverse() != orig || UTF8string( "aがb" ).utf8_reverse() != UTF8string( "bがa" ) )
+            return 161;
+    }
+
+    // Substrings of a large string
+    {
+        const std::string CPOINTS[] = {"a", "é", "が", "😀"};
+        std::string raw;
+
+        for ( size_t i = 0; i < 2000; ++i )
+        {
+            raw += CPOINTS[i % 4];
+        }
+
+        const UTF8string u8( raw );
+        const UTF8string sub = u8.utf8_substr( 1501, 6 );
+
+        if ( sub != UTF8string( "éが😀aéが" ) || sub.utf8_length() != 6 || sub.utf8_size() != 15 )
+            return 170;
+
+        if ( u8.utf8_substr( 1998 ) != UTF8string( "が😀" ) || !u8.utf8_substr( 2000 ).utf8_empty()
+                || u8.utf8_substr( 0, 4 ).utf8_size() != 10 || UTF8string( u8, 1999, 8 ) != UTF8string( "😀" ) )
+            return 173;
+    }
+
+    // Erase in place
+    {
+        UTF8string u8( "がんばつて\tGumichan\r\n 01\x7F" );
+        const size_t N = u8.utf8_erase_if( []( const UTF8char& c )
+        {
+            return c.utf8_codepoint() < 0x20 || c.utf8_codepoint() == 0x7F;
+        } );
+
+        if ( N != 4 || u8 != UTF8string( "がんばつてGumichan 01" ) || u8.utf8_length() != 16 )
+            return 174;
+
+        const UTF8iterator it = u8.utf8_erase( u8.utf8_begin() + 2, u8.utf8_begin() + 5 );
+
+        if ( it - u8.utf8_begin() != 2 || *it != "G" || u8 != UTF8string( "がんGumichan 01" ) )
+            return 175;
+
+        if ( *u8.utf8_erase( u8.utf8_begin() + 1 ) != "G" || u8.utf8_erase( 9, 42 ) != UTF8string( "がGumichan" ) )
+            return 176;
+
+        std::string raw;
+
+        for ( size_t i = 0; i < 3000; ++i )
+        {
+            raw += i % 2 == 0 ? "が" : "a";
+        }
+
+        // The index of the large string is partially kept
+        UTF8string large( raw );
+
+        if ( large[2999] != "a" || large.utf8_erase( 1000, 1000 ).utf8_length() != 2000 || large[1999] != "a" )
+            return 177;
+
+        if ( large.utf8_erase_if( []( const UTF8char& c ) { return c == "a"; } ) != 1000 || large[999] != "が" )
+            return 178;
+    }
+
+    // Build a string from fragments
+    {
+        const UTF8string gumi( "Gumi" );
+        const std::string trusted( "chan 01" );
+        UTF8builder builder;
+        builder.utf8_reserve( 64 );
+
+        builder.utf8_append( U'が' ).utf8_append( "んばつて" ).utf8_append( char32_t( ' ' ) );
+        builder.utf8_append( gumi ).utf8_append_unchecked( trusted.data(), 4 );
+        builder.utf8_append( UTF8string_view( gumi ).utf8_substr( 0, 1 ) ).utf8_append( UTF8char( U'😀' ) );
+
+        if ( builder.utf8_length() != 16 || builder.utf8_build() != UTF8string( "がんばつて GumichanG😀" ) )
+            return 188;
+
+        try
+        {
+            builder.utf8_append( std::string( "\xED\xA0\x80" ) );
+            return 189;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        try
+        {
+            builder.utf8_append( char32_t( 0x110000 ) );
+            return 190;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        const UTF8string u8 = std::move( builder ).utf8_build();
+
+        if ( u8.utf8_length() != 16 || u8.utf8_size() != 29 || builder.utf8_length() != 0 || builder.utf8_size() != 0 )
+            return 191;
+
+        // An empty UTF8char is not a codepoint
+        UTF8builder empty;
+        const UTF8string ab = empty.utf8_append( UTF8char() ).utf8_append( "ab" ).utf8_build();
+
+        if ( ab.utf8_length() != 2 || ab.utf8_size() != 2 || UTF8string( ab.utf8_sstring() ).utf8_length() != 2 )
+            return 156;
+    }
+
+    // ASCII strings
+    {
+        std::string raw;
+
+        for ( size_t i = 0; i < 5000; ++i )
+        {
+            raw += static_cast<char>( 'a' + i % 26 );
+        }
+
+        UTF8string u8( raw );
+
+        if ( !u8.utf8_is_ascii() || u8[4001] != "x" || u8.utf8_substr( 4000, 3 ) != UTF8string( "wxy" ) )
+            return 192;
+
+        if ( u8.utf8_find( UTF8string( "xyz" ), 4000 ) != 4001 || u8.utf8_rfind( UTF8string( "abc" ) ) != 4992 )
+            return 193;
+
+        u8 += "が";
+
+        if ( u8.utf8_is_ascii() || u8[5000] != "が" || u8.utf8_substr( 4998 ) != UTF8string( "ghが" ) )
+            return 194;
+
+        u8.utf8_pop();
+        u8.utf8_erase( 0, 26 );
+
+        if ( !u8.utf8_is_ascii() || u8.utf8_length() != 4974 || u8[25] != "z" || UTF8string_view( u8 ).utf8_at( 26 ) != "a" )
+            return 195;
+
+        if ( u8.utf8_substr( 0, 3 ).utf8_reverse() != UTF8string( "cba" ) || !UTF8string().utf8_is_ascii() )
+            return 196;
+    }
+
+    // Allocator-aware string
+    {
+        const std::allocator<char> alloc;
+        UTF8basic_string<> u8( "がんばつて", alloc );
+        UTF8string u8b( std::string( "Gumichan" ), u8.get_allocator() );
+
+        if ( u8.utf8_length() != 5 || u8 + u8b != UTF8string( "がんばつてGumichan" ) )
+            return 204;
+
+        UTF8string u8c( alloc );
+        u8c = UTF8string( UTF8string_view( u8 ) );
+
+        if ( !( u8c == u8 ) || std::hash<UTF8basic_string<>>()( u8c ) != UTF8string_view( u8 ).hash() )
+            return 205;
+
+#if defined( UTF8_STRING_PMR )
+        char buffer[1024];
+        std::pmr::monotonic_buffer_resource pool( buffer, sizeof( buffer ) );
+        std::pmr::polymorphic_allocator<char> palloc( &pool );
+
+        UTF8pmr_string p( "ドロテ: すみません", palloc );
+        p += "、ゆうびんきょくはどこですか";
+
+        if ( p.get_allocator().resource() != &pool || p.utf8_length() != 24 )
+            return 206;
+
+        if ( p.utf8_find( UTF8pmr_string( "すみません" ) ) != 5 || *( p.utf8_begin() + 4 ) != " "
+                || UTF8string( UTF8string_view( p ) ) != UTF8string( "ドロテ: すみません、ゆうびんきょくはどこですか" ) )
+            return 207;
+
+        const std::pmr::string s = std::move( p ).utf8_sstring();
+
+        if ( !p.utf8_empty() || s.get_allocator().resource() != &pool )
+            return 208;
+
+        // The allocator does not follow a moved pmr string, the content is copied
+        static_assert( !std::is_nothrow_move_assignable<UTF8pmr_string>::value, "pmr move can allocate" );
+
+        std::pmr::monotonic_buffer_resource other;
+        UTF8pmr_string q( "がんばつて", palloc );
+        const std::pmr::polymorphic_allocator<char> oalloc( &other );
+        UTF8pmr_string r( oalloc );
+        r = std::move( q );
+
+        if ( r != UTF8pmr_string( "がんばつて" ) || r.utf8_length() != 5 || r.get_allocator().resource() != &other || !q.utf8_empty() )
+            return 209;
+#endif
+    }
+
+    // Records loaded from one buffer
+    {
+        UTF8records records( jap1 + jap2 + "\n" + jap6 );
+
+        if ( records.utf8_count() != 4 || records.utf8_size() != jap1.size() + jap2.size() + 1 + jap6.size() )
+            return 214;
+
+        if ( records[0] != UTF8string_view( jap1.data(), jap1.size() - 1 ) || records[1].utf8_length() != 56
+                || !records[2].utf8_empty() || records.utf8_at( 3 ) != UTF8string( jap6 ) )
+            return 215;
+
+        std::istringstream is( "Gumichan;がんばつて;" );
+        UTF8records fields( is, ';' );
+
+        if ( fields.utf8_count() != 2 || fields[1].utf8_length() != 5 || fields[1].utf8_find( UTF8string( "つ" ) ) != 3 )
+            return 216;
+
+        // A stream that can tell its position but cannot seek to its end
+        struct NoEndBuffer : std::stringbuf
+        {
+            explicit NoEndBuffer( const std::string& str ) : std::stringbuf( str, std::ios::in ) {}
+
+            pos_type seekoff( off_type off, std::ios::seekdir dir, std::ios::openmode which ) override
+            {
+                return dir == std::ios::end ? pos_type( off_type( -1 ) ) : std::stringbuf::seekoff( off, dir, which );
+            }
+        };
+
+        NoEndBuffer noend( "Gumichan;がんばつて" );
+        std::istream nis( &noend );
+        UTF8records nofields( nis, ';' );
+
+        if ( nofields.utf8_count() != 2 || nofields[1].utf8_length() != 5 )
+            return 149;
+
+        // The delimiter is the last byte of a block of 64 bytes
+        UTF8records edge( std::string( 61, 'a' ) + "が\n" + std::string( 70, 'b' ) + "😀" );
+
+        if ( edge.utf8_count() != 2 || edge[0].utf8_length() != 62 || edge[1].utf8_length() != 71 || edge[1].utf8_size() != 74 )
+            return 157;
+
+        try
+        {
+            UTF8records( std::string( "ok\nがんば\xFF\nok" ) );
+            return 217;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        try
+        {
+            UTF8records( jap1.data(), jap1.size(), '\xE3' );
+            return 218;
+        }
+        catch ( const std::invalid_argument& ) {}
+    }
+
+    // Interned strings
+    {
+        UTF8interner interner;
+        const UTF8string ganbatsute( "がんばつて" );
+        const UTF8interner::handle h1 = interner.utf8_intern( ganbatsute );
+        const UTF8interner::handle h2 = interner.utf8_intern( UTF8string( "がんばつて" ) );
+        const UTF8interner::handle h3 = interner.utf8_intern( UTF8string( "Gumichan" ) );
+
+        if ( !h1 || h1 != h2 || h1 == h3 || interner.utf8_count() != 2 )
+            return 219;
+
+        if ( h1.utf8_view() != ganbatsute || h1.hash() != ganbatsute.hash() || h3.utf8_view().utf8_length() != 8 )
+            return 227;
+
+        if ( interner.utf8_lookup( UTF8string( "Gumichan" ) ) != h3 || interner.utf8_lookup( UTF8string( "Gumi" ) ) )
+            return 228;
+
+        UTF8records records( jap1 + jap3 + jap5 + jap3 + jap1 + std::string( 20000, 'a' ) );
+        const std::vector<UTF8interner::handle> handles = interner.utf8_intern( records );
+
+        if ( handles.size() != 6 || interner.utf8_count() != 6 || handles[0] != handles[4] || handles[1] != handles[3] )
+            return 229;
+
+        std::vector<UTF8string> words;
+
+        for ( size_t i = 0; i < 3000; ++i )
+        {
+            words.push_back( UTF8string( std::to_string( i % 1000 ) + "つ" ) );
+        }
+
+        const std::vector<UTF8interner::handle> numbers = interner.utf8_intern( words );
+        const UTF8interner::usage U = interner.utf8_usage();
+
+        if ( interner.utf8_count() != 1006 || numbers[1999] != numbers[999] || numbers[2999].utf8_view() != UTF8string( "999つ" ) )
+            return 254;
+
+        if ( U.strings != 1006 || U.string_bytes < 20000 || U.block_bytes < U.string_bytes || U.table_bytes < 2012 * sizeof( void * ) )
+            return 255;
+
+        UTF8interner moved( std::move( interner ) );
+
+        if ( moved.utf8_lookup( ganbatsute ) != h1 || interner.utf8_count() != 0 || interner.utf8_lookup( ganbatsute ) )
+            return 199;
+
+        const UTF8interner::handle EMPTY = moved.utf8_intern( UTF8string_view() );
+
+        if ( !EMPTY || !EMPTY.utf8_view().utf8_empty() || moved.utf8_lookup( UTF8string_view() ) != EMPTY
+                || moved.utf8_intern( UTF8string() ) != EMPTY || moved.utf8_count() != 1007 )
+            return 198;
+    }
+
+    // Hash value kept by the string
+    {
+        UTF8string u8( jap2 );
+        const size_t H = u8.hash();
+        const UTF8string copy( u8 );
+
+        if ( H != UTF8string_view( u8 ).hash() || copy.hash() != H || std::hash<UTF8string>()( u8 ) != H )
+            return 236;
+
+        u8 += "!";
+
+        if ( u8.hash() == H || u8.hash() != UTF8string( jap2 + "!" ).hash() )
+            return 237;
+
+        u8.utf8_pop();
+
+        if ( u8.hash() != H || u8.utf8_erase( 0, 4 ).hash() != UTF8string( jap2 ).utf8_substr( 4 ).hash()
+                || u8.utf8_reverse().hash() != UTF8string_view( u8 ).hash() )
+            return 238;
+
+        std::unordered_map<UTF8string, size_t> counts;
+        counts[UTF8string( jap1 )] += 1;
+        counts[UTF8string( jap1 )] += 1;
+        counts[copy] += 1;
+
+        if ( counts.size() != 2 || counts[UTF8string( jap1 )] != 2 )
+            return 239;
+    }
+
+    // Comparisons on the bytes
+    {
+        const UTF8string ganba( "がんば" );
+        const UTF8string ganbatsute( "がんばつて" );
+        const std::string gumi( "Gumichan" );
+
+        if ( ganba.utf8_compare( ganbatsute ) >= 0 || ganbatsute.utf8_compare( ganba ) <= 0 || ganba.utf8_compare( "がんば" ) != 0 )
+            return 248;
+
+        if ( UTF8string( gumi ).utf8_compare( ganba ) >= 0 || ganba.utf8_compare( gumi ) <= 0
+                || ganbatsute.utf8_compare( UTF8string_view( ganbatsute ).utf8_substr( 0, 3 ) ) <= 0 )
+            return 249;
+
+        if ( !( ganba == "がんば" ) || "がんば" != ganba || !( ganba < "がんばつ" ) || !( "Gumi" < ganba ) || !( ganba >= "がん" ) )
+            return 250;
+
+        if ( ganbatsute == gumi || !( gumi < ganbatsute ) || !( ganbatsute > gumi ) || !( UTF8string( gumi ) == gumi ) || !( gumi <= UTF8string( gumi ) ) )
+            return 251;
+
+        // The hash values are only used to find different strings
+        UTF8string h1( "がんばつて" );
+        UTF8string h2( "がんばつで" );
+        h1.hash();
+        h2.hash();
+
+        if ( h1 == h2 || !( h1 < h2 ) || h1 != ganbatsute || UTF8string() != "" )
+            return 252;
+
+        std::vector<UTF8string> words = { ganbatsute, UTF8string( gumi ), ganba, UTF8string( "Gumi" ) };
+        std::sort( words.begin(), words.end() );
+
+        if ( words[0] != "Gumi" || words[1] != gumi || words[2] != ganba || words[3] != ganbatsute )
+            return 253;
+    }
+
+    // Conversions to UTF-16 and UTF-32
+    {
+        const UTF8string ascii( "Long enough to be converted by blocks of sixteen characters" );
+        const UTF8string mixed( "がんばつて Gumichan, all of them 😀 are here 😀" );
+        const std::u32string U32 = U"がんばつて Gumichan, all of them 😀 are here 😀";
+        const std::u16string U16 = u"がんばつて Gumichan, all of them 😀 are here 😀";
+
+        if ( mixed.utf8_to_u32() != U32 || mixed.utf8_to_u16() != U16 || UTF8string().utf8_to_u32() != U"" )
+            return 124;
+
+        if ( ascii.utf8_to_u16().size() != ascii.utf8_length() || UTF8string::from_u16( ascii.utf8_to_u16() ) != ascii
+                || UTF8string::from_u32( ascii.utf8_to_u32() ) != ascii )
+            return 125;
+
+        const UTF8string from16 = UTF8string::from_u16( U16 );
+        const UTF8string from32 = UTF8string::from_u32( U32 );
+
+        if ( from16 != mixed || from32 != mixed || from16.utf8_length() != mixed.utf8_length()
+                || from32.utf8_length() != mixed.utf8_length() || U16.size() != mixed.utf8_length() + 2 )
+            return 126;
+
+        try
+        {
+            UTF8string::from_u16( u"Gumi" + std::u16string( 1, char16_t( 0xD800 ) ) );
+            return 127;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        try
+        {
+            UTF8string::from_u32( std::u32string( 1, char32_t( 0x110000 ) ) );
+            return 128;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        try
+        {
+            UTF8string::from_u32( std::u32string( 1, char32_t( 0xDFFF ) ) );
+            return 129;
+        }
+        catch ( const std::invalid_argument& ) {}
+    }
+
+    // Validation without exception
+    {
+        const UTF8result ok = UTF8string::try_from( jap1 );
+
+        if ( !ok || ok.utf8_error() != UTF8error::NONE || ok.utf8_error_bpos() != UTF8string::npos || ok.utf8_value() != UTF8string( jap1 ) )
+            return 133;
+
+        std::string bad( "Gumichan がんば \xE3\x81 ok" );
+        const UTF8result r = UTF8string::try_from( bad );
+
+        if ( r || r.utf8_error() != UTF8error::MISSING_CONTINUATION || r.utf8_error_bpos() != 19 )
+            return 134;
+
+        try
+        {
+            r.utf8_value();
+            return 135;
+        }
+        catch ( const std::invalid_argument& ) {}
+
+        // The buffer is not taken if the content is invalid
+        const UTF8result moved = UTF8string::try_from( std::move( bad ) );
+
+        if ( moved || bad.size() != 24 || !UTF8string::try_from( std::string( "がんば" ) ) )
+            return 136;
+
+        const std::string ERRORS[] = { "a\x80", "\xC1\xBF", "ab\xED\xA0\x80", "\xF4\x90\x80\x80", "abc\xF0\x9F\x98", "\xFF" };
+        const UTF8error KINDS[] = { UTF8error::UNEXPECTED_CONTINUATION, UTF8error::OVERLONG, UTF8error::SURROGATE,
+                                    UTF8error::TOO_LARGE, UTF8error::TRUNCATED, UTF8error::INVALID_BYTE
+                                  };
+        const size_t BPOS[] = { 1, 0, 2, 0, 3, 0 };
+
+        for ( size_t i = 0; i < 6; ++i )
+        {
+            const UTF8result e = UTF8string::try_from( ERRORS[i].data(), ERRORS[i].size() );
+
+            if ( e.utf8_error() != KINDS[i] || e.utf8_error_bpos() != BPOS[i] )
+                return 137;
+        }
+
+        UTF8string value = UTF8string::try_from( "がんばつて" ).utf8_value();
+
+        if ( value.utf8_length() != 5 || value != "がんばつて" )
+            return 138;
+    }
+
+    // Lossy construction, the invalid sequences are replaced by U+FFFD
+    {
+        const UTF8string valid = UTF8string::from_lossy( jap1 );
+
+        if ( valid != UTF8string( jap1 ) || valid.utf8_length() != UTF8string( jap1 ).utf8_length() )
+            return 143;
+
+        // The example of the Unicode standard (maximal subparts)
+        const char INVALID[] = "\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64";
+        const UTF8string repaired = UTF8string::from_lossy( INVALID );
+
+        if ( repaired != "a\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD" "b\xEF\xBF\xBD" "c\xEF\xBF\xBD\xEF\xBF\xBD" "d"
+                || repaired.utf8_length() != 10 )
+            return 144;
+
+        const UTF8string truncated = UTF8string::from_lossy( std::string( "がんば\xF0\x9F\x98" ) );
+
+        if ( truncated != "がんば\xEF\xBF\xBD" || truncated.utf8_length() != 4 || UTF8string::from_lossy( "" ).utf8_length() != 0 )
+            return 145;
+
+        // A valid buffer is taken
+        std::string buffer( "Gumichan がんばつて, long enough not to be a small string" );
+        const char * const DATA = buffer.data();
+        const UTF8string taken = UTF8string::from_lossy( std::move( buffer ) );
+
+        if ( taken.utf8_str() != DATA || taken.utf8_length() != 52 )
+            return 146;
+
+        const UTF8string surrogate = UTF8string::from_lossy( std::string( "\xED\xA0\x80!" ) );
+
+        if ( surrogate.utf8_length() != 4 || surrogate.utf8_at( 3 ) != "!" )
+            return 147;
+    }
+
     // Last test : search for a substring in a file
     {
         UTF8string text;